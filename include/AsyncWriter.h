@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+/*
+ * AsyncWriter.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include "OPC-UA-Connection.h"
+
+#include <open62541/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ChimeraTK {
+
+  /**
+   * Sends writes asynchronously, so writing accessors do not wait for the response of the server (fire and forget).
+   *
+   * Writes are queued by write() and sent by a separate thread using the asynchronous client API. Writes of different
+   * nodes are pipelined, i.e. several requests are in flight at the same time. Writes of the same node are sent one
+   * after the other, so their order is preserved. Every value is sent - writes are not coalesced. If maxPending writes
+   * are queued or in flight write() blocks until one is completed (backpressure).
+   *
+   * A failed write is reported via the onFailure callback and the next call of write() throws.
+   */
+  class OPCUAAsyncWriter {
+   public:
+    /**
+     * \param connection The connection used to send the writes.
+     * \param maxPending Maximum number of writes queued or in flight.
+     * \param onFailure Called from the writer thread with a message describing the failed write. No lock is held when
+     *                  calling it. It is called once per failure.
+     */
+    OPCUAAsyncWriter(std::shared_ptr<OPCUAConnection> connection, size_t maxPending,
+        std::function<void(const std::string&)> onFailure);
+    ~OPCUAAsyncWriter();
+
+    /**
+     * Queue a write of the given value to the given node or to the given index range of the node if not empty. All are
+     * copied.
+     *
+     * \throws ChimeraTK::runtime_error if a previous write failed or if the write can not be queued within the
+     *         connection timeout, because the server does not answer.
+     */
+    void write(const UA_NodeId& node, const UA_Variant& value, const std::string& browseName,
+        const std::string& indexRange = "");
+
+    /**
+     * Wait until all writes of the given node that are queued or in flight are completed. This is needed before reading
+     * the node, e.g. for a read-modify-write of a part of an array.
+     */
+    void waitUntilWritten(const UA_NodeId& node);
+
+    /**
+     * Drop queued writes and errors of a previous session and start the writer thread if not running yet.
+     */
+    void start();
+
+    /**
+     * Stop the writer thread. Queued writes that were not sent yet are dropped.
+     */
+    void stop();
+
+    [[nodiscard]] bool isRunning() const { return _run; }
+
+   private:
+    /**
+     * Write queued or in flight.
+     */
+    struct PendingWrite {
+      UA_NodeId node;
+      UA_Variant value;
+      std::string indexRange; ///< Range of the node written - the whole node is written if empty
+      std::string browseName; ///< Name of the register written - only used for error messages
+      UA_UInt32 requestId{0}; ///< Id of the request if in flight, else 0
+    };
+
+    /**
+     * Send all queued writes of nodes that have no write in flight.
+     *
+     * \remark The client lock needs to be held. Holds the lock.
+     */
+    void sendPending();
+
+    /**
+     * Callback of the asynchronous write request.
+     *
+     * \remark Called with the client lock held - either in the writer thread or by other threads iterating the client.
+     */
+    static void writeCallback(UA_Client* client, void* userdata, UA_UInt32 requestId, UA_WriteResponse* response);
+
+    /**
+     * Remove the write with the given request id and store the error if it failed.
+     *
+     * \remark Holds the lock.
+     */
+    void complete(UA_UInt32 requestId, UA_StatusCode status);
+
+    /**
+     * Remove all writes and free their content.
+     *
+     * \remark Lock needs to be held.
+     */
+    void clear();
+
+    /**
+     * Send the queued writes and process the responses. Launched in a separate thread by start().
+     */
+    void run();
+
+    std::shared_ptr<OPCUAConnection> _connection;
+    size_t _maxPending;
+    std::function<void(const std::string&)> _onFailure;
+
+    /// Writes queued or in flight in the order they were issued.
+    std::list<PendingWrite> _pending;
+
+    /// Number of writes in flight.
+    size_t _inFlight{0};
+
+    /// Message of the first failed write. Empty if no write failed.
+    std::string _error;
+
+    /// True if the error was reported via onFailure.
+    bool _errorReported{false};
+
+    std::unique_ptr<std::thread> _thread;
+    std::atomic<bool> _run{false};
+    std::mutex _mutex; ///< Protects the pending writes and the error
+    std::condition_variable _condition;
+  };
+} // namespace ChimeraTK
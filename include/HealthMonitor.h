@@ -0,0 +1,95 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+/*
+ * HealthMonitor.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include "OPC-UA-Connection.h"
+
+#include <open62541/types.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace ChimeraTK {
+
+  /**
+   * Settings of the health monitor given as device parameters.
+   */
+  struct HealthMonitorSettings {
+    uint32_t interval{0};         ///< Probe interval in ms. If 0 the health monitor is disabled.
+    double maxRoundTripTime{0};   ///< A warning is printed if the round trip time exceeds this value in ms (0 = off).
+
+    [[nodiscard]] bool enabled() const { return interval > 0; }
+  };
+
+  /**
+   * Actively probes the server by reading ServerStatus.State and ServerStatus.StartTime in a single read request.
+   *
+   * Without the health monitor a connection loss is only detected by the subscription inactivity callback (several
+   * publishing intervals times the lifetime count) or by a failed transfer. The health monitor detects it within one
+   * probe interval plus the connection timeout of the client and reports whether the server restarted (changed start
+   * time, lost session, server state not running) or the link dropped.
+   */
+  class OPCUAHealthMonitor {
+   public:
+    /**
+     * \param connection The connection to be probed.
+     * \param settings The probe settings.
+     * \param onFailure Called from the health monitor thread with a message describing the failure. The client lock is
+     *                  not held when calling it. It is called once per failure - probing continues only after the
+     *                  connection was established again.
+     */
+    OPCUAHealthMonitor(std::shared_ptr<OPCUAConnection> connection, const HealthMonitorSettings& settings,
+        std::function<void(const std::string&)> onFailure);
+    ~OPCUAHealthMonitor();
+
+    /**
+     * Start the probe thread if not running yet.
+     */
+    void start();
+
+    /**
+     * Stop the probe thread.
+     */
+    void stop();
+
+    [[nodiscard]] bool isRunning() const { return _run; }
+
+   private:
+    /**
+     * Read state and start time of the server.
+     *
+     * \return An empty string if the server is healthy, else a message describing the failure.
+     */
+    std::string probe();
+
+    /**
+     * Probe loop. Launched in a separate thread by start().
+     */
+    void run();
+
+    std::shared_ptr<OPCUAConnection> _connection;
+    HealthMonitorSettings _settings;
+    std::function<void(const std::string&)> _onFailure;
+
+    /// Start time of the server seen by the first probe after the connection was established. 0 if not known yet.
+    UA_DateTime _startTime{0};
+    /// True if a failure was reported. Reset once the connection was closed and established again.
+    bool _failed{false};
+    /// True if the last probe exceeded the maximum round trip time. Used to print the warning only once.
+    bool _slow{false};
+
+    std::unique_ptr<std::thread> _thread;
+    std::atomic<bool> _run{false};
+    std::mutex _mutex;
+    std::condition_variable _stopCondition;
+  };
+} // namespace ChimeraTK
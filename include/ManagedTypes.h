@@ -4,6 +4,7 @@
 
 #include <open62541/types.h>
 
+#include <algorithm>
 #include <string>
 /*
  * ManagedTypes.h
@@ -55,7 +56,23 @@ namespace ChimeraTK {
      * This method is used to create a temporary object before moving it to the accessors
      * FutureQueue
      */
-    explicit ManagedDataValue(UA_DataValue* data);
+    explicit ManagedDataValue(const UA_DataValue* data);
+
+    /**
+     * Does not take ownership of the internal UA_DataVale - will not be cleared.
+     *
+     * Only the array elements [offset, offset + length) of data are copied. This is used to slice the window of an
+     * accessor out of the data of a monitored item that is shared by several accessors.
+     */
+    ManagedDataValue(const UA_DataValue* data, size_t offset, size_t length);
+
+    /**
+     * Does not take ownership of the internal UA_DataVale - will not be cleared.
+     *
+     * Only the given index range of data is copied, e.g. "1:2,0:9" for a two-dimensional array. This is used to slice
+     * the range of a multi-dimensional register out of the data of the whole node.
+     */
+    ManagedDataValue(const UA_DataValue* data, const std::string& range);
     ~ManagedDataValue();
     [[nodiscard]] bool hasValue() const { return _val.hasValue; };
 
@@ -67,8 +84,33 @@ namespace ChimeraTK {
 
     /**
      * Copy Variant. Takes the ownership of the Variant - the internal  UA_DataValue will be cleared.
+     * If no range is given and the variant already holds a value of the same type and size whose elements contain no
+     * pointers, the elements are overwritten in place without allocating memory.
      */
     void copyVariant(const UA_Variant& src, const std::string& dataRange);
+
+    /**
+     * Take over the content of data, which is reset afterwards. The internal UA_DataValue will be cleared.
+     */
+    void moveFrom(UA_DataValue* data);
+
+    /**
+     * Copy the array of data to the elements starting at offset. If no array of the given length and the type of data
+     * is present yet it is created first. This is used to assemble the data of a node that is monitored in chunks.
+     * The newest source and server time stamps are kept. The internal UA_DataValue will be cleared. Scalars are copied
+     * like arrays of one element, which is used to assemble the nodes of a channel group.
+     */
+    UA_StatusCode setRange(const UA_DataValue* data, size_t offset, size_t length);
+
+    /**
+     * Make sure a variant of the given type and shape is held, e.g. to fill it with values to be written. A variant of
+     * that type and shape held already is kept, so its elements can be overwritten without allocating memory. Else
+     * a new variant is allocated. The internal UA_DataValue will be cleared.
+     *
+     * \param length Number of elements. Ignored if scalar is true.
+     */
+    UA_StatusCode allocate(const UA_DataType* type, size_t length, bool scalar);
+    [[nodiscard]] const UA_DataValue* getDataValue() const { return &_val; }
     [[nodiscard]] void* getValue() const { return _val.value.data; }
     [[nodiscard]] UA_Variant* getVariant() { return &_val.value; }
     [[nodiscard]] UA_DateTime getSourceTime() const { return _val.sourceTimestamp; }
@@ -82,5 +124,41 @@ namespace ChimeraTK {
     UA_DataValue _val{};    ///< Data to be managed by this wrapper
     bool _clearData{false}; ///< If true the UA_DataValue _val is cleared on destruction
     void prepare();
+
+    /**
+     * Overwrite the elements of the owned variant with the ones of src if type and size match and the elements contain
+     * no pointers.
+     *
+     * \return False if the variant can not be reused.
+     */
+    bool reuseVariant(const UA_Variant& src);
   };
+
+  /**
+   * Call f(bytes, index, count) for the parts of the blobs of a ByteString variant (scalar or array) that cover the
+   * elements [offset, offset + length) of a register holding the bytes of all blobs one after another. index is the
+   * register element of the first byte relative to offset and count the number of bytes. The bytes are not copied.
+   *
+   * \return Number of elements covered. It is smaller than length if the blobs are shorter than expected.
+   */
+  template<typename Function>
+  size_t forEachByteStringSegment(const UA_Variant& variant, size_t offset, size_t length, Function f) {
+    if(variant.type != &UA_TYPES[UA_TYPES_BYTESTRING]) {
+      return 0;
+    }
+    auto* blobs = static_cast<UA_ByteString*>(variant.data);
+    size_t nBlobs = UA_Variant_isScalar(&variant) ? 1 : variant.arrayLength;
+    size_t blobStart = 0; // register element of the first byte of the current blob
+    size_t covered = 0;
+    for(size_t i = 0; i < nBlobs && blobStart < offset + length; ++i) {
+      size_t begin = std::max(offset, blobStart);
+      size_t end = std::min(offset + length, blobStart + blobs[i].length);
+      if(begin < end) {
+        f(blobs[i].data + (begin - blobStart), begin - offset, end - begin);
+        covered += end - begin;
+      }
+      blobStart += blobs[i].length;
+    }
+    return covered;
+  }
 } // namespace ChimeraTK
\ No newline at end of file
@@ -15,6 +15,7 @@
 
 #include <deque>
 #include <string>
+#include <vector>
 
 namespace ChimeraTK {
   struct MapElement {
@@ -24,22 +25,32 @@ namespace ChimeraTK {
     UA_NodeId _node{};      ///< OPC UA Node Id (zero-initialized)
     std::string _range{""}; ///< Range string, e.g. 2:4
     std::string _name{""};  ///< Name that is used in the device. If empty it is constructed from the nodeID
+    OpcUABackendRegisterOptions _options{}; ///< Register specific options
+    /**
+     * Nodes of a channel group, i.e. one register whose channels are the given nodes. _node is the first of them.
+     * Empty for ordinary elements.
+     */
+    std::vector<MapElement> _channels{};
     /**
      * Construct MapElement for int node ID.
      * @param id Node ID.
      * @param ns Namespace.
      * @param range Range string, e.g. 3:8.
      * @param name Name that is used in the device. If empty it is constructed from the nodeID
+     * @param options Register specific options.
      */
-    MapElement(const UA_UInt32& id, const UA_UInt16& ns, const std::string& range, const std::string& name);
+    MapElement(const UA_UInt32& id, const UA_UInt16& ns, const std::string& range, const std::string& name,
+        const OpcUABackendRegisterOptions& options = {});
     /**
      * Construct MapElement for string node ID.
      * @param id Node ID.
      * @param ns Namespace.
      * @param range Range string, e.g. 3:8.
      * @param name Name that is used in the device. If empty it is constructed from the nodeID
+     * @param options Register specific options.
      */
-    MapElement(const std::string& id, const UA_UInt16& ns, const std::string& range, const std::string& name);
+    MapElement(const std::string& id, const UA_UInt16& ns, const std::string& range, const std::string& name,
+        const OpcUABackendRegisterOptions& options = {});
     ~MapElement();
 
     // Copy constructor - deep copy the NodeId
@@ -64,6 +75,9 @@ namespace ChimeraTK {
     /** @brief Parse the map file and fill the element list.
      */
     void readElements();
+    /** @brief Parse a group element, i.e. a register made of several nodes, and add it to the element list.
+     */
+    void readGroup(const xmlpp::Element* group);
     xmlpp::Element* _rootNode{nullptr};
     std::string _file; ///< Name of the map file
     std::string _serverRootNode;
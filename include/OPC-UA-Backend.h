@@ -7,8 +7,13 @@
  *  Created on: Nov 19, 2018
  *      Author: Klaus Zenker (HZDR)
  */
+#include "AsyncWriter.h"
+#include "HealthMonitor.h"
+#include "PollScheduler.h"
 #include "OPC-UA-Connection.h"
+#include "PubSubSubscriber.h"
 #include "RegisterInfo.h"
+#include "StructureType.h"
 #include "SubscriptionManager.h"
 
 #include <ChimeraTK/BackendRegisterCatalogue.h>
@@ -23,6 +28,7 @@
 #include <memory>
 #include <mutex>
 #include <sstream>
+#include <utility>
 
 namespace ChimeraTK {
   class OPCUASubscriptionManager;
@@ -45,6 +51,15 @@ namespace ChimeraTK {
   typedef std::unordered_set<UA_NodeId, NodeHash, NodeComp> UASet;
   */
 
+  /**
+   * Settings of the priority lane given as device parameters. The priority lane is only set up if the catalogue
+   * includes registers with high priority.
+   */
+  struct PriorityLaneSettings {
+    double publishingInterval{0}; ///< Publishing interval of the priority lane in ms. If 0 the default one is used.
+    int realtimePriority{0};      ///< SCHED_FIFO priority of the priority lane thread. If 0 no real-time scheduling.
+  };
+
   /**
    * \remark Closing the an application using SIGINT will trigger closing the session. Thus, the state handler will
    * trigger OPCUASubscriptionManager::deactivateAllAndPushException. At the same time, in the destructor of the
@@ -95,6 +110,21 @@ namespace ChimeraTK {
      * \param revocationListFolder Folder that includes revocation lists
      * \param cacheFile Name of te cache file. If set the catalogue will be created from the cache and
      *                  not by reading rhe map file or browsing the server.
+     * \param subscriptionSettings Tuning parameters of the subscription. Parameters set to 0 are derived
+     *                             automatically.
+     * \param pubSubSettings If enabled registers with a DataSetWriter id are received via PubSub instead of the
+     *                       subscription.
+     * \param prioritySettings Settings of the client session and subscription used for high priority registers.
+     * \param healthSettings If enabled the server state is probed periodically to detect connection losses and
+     *                       server restarts.
+     * \param registerNodes If true the nodes of the catalogue are registered with the RegisterNodes service after
+     *                      connecting and the aliases returned by the server are used.
+     * \param maxAge Maximum age in ms of values the server may return from its cache for synchronous reads.
+     * \param maxPendingWrites If not 0 writes are sent asynchronously and up to this number of writes per lane are
+     *                         queued or in flight. Failed writes are reported via setException().
+     * \param maxMessageSize Maximum size in bytes of messages received by the client. If 0 the open62541 default is
+     *                       used. Arrays that do not fit into a message are read in pages (see OPCUAPagedTransfer
+     *                       for writes).
      */
     explicit OpcUABackend(const std::string& fileAddress, const std::string& username = "",
         const std::string& password = "", const std::string& mapfile = "",
@@ -102,7 +132,10 @@ namespace ChimeraTK {
         const uint32_t& connectionTimeout = 5000, const UA_LogLevel& logLevel = UA_LOGLEVEL_ERROR,
         const std::string& certificate = "", const std::string& privateKey = "", const bool& trustAny = true,
         const std::string& trustListFolder = "", const std::string& revocationListFolder = "",
-        const std::string& cacheFile = "");
+        const std::string& cacheFile = "", const SubscriptionSettings& subscriptionSettings = {},
+        const PubSubSettings& pubSubSettings = {}, const PriorityLaneSettings& prioritySettings = {},
+        const HealthMonitorSettings& healthSettings = {}, const bool& registerNodes = true,
+        const double& maxAge = 0, const size_t& maxPendingWrites = 0, const uint32_t& maxMessageSize = 0);
 
     /**
      * Fill catalog.
@@ -142,8 +175,75 @@ namespace ChimeraTK {
 
     void activateAsyncRead() noexcept override;
 
+    /**
+     * Get the number of synchronous reads that were merged with a read of the same node in flight, i.e. that did not
+     * send a request to the server.
+     */
+    [[nodiscard]] size_t getNumberOfMergedReads() const {
+      return _connection->mergedReads + (_priorityConnection ? _priorityConnection->mergedReads.load() : 0);
+    }
+
+    /**
+     * Get the number of OPC UA monitored items of the subscriptions of both lanes, e.g. to check if registers share a
+     * monitored item. Chunks and channels of a group count as separate monitored items.
+     */
+    [[nodiscard]] size_t getNumberOfMonitoredItems() const;
+
     // Used to add the subscription support -> subscriptions are not active until activateAsyncRead() is called.
-    void activateSubscriptionSupport();
+    void activateSubscriptionSupport(const OpcUABackendRegisterInfo& info);
+
+    /**
+     * Get the connection of the lane used by the given register.
+     */
+    std::shared_ptr<OPCUAConnection>& getConnection(const OpcUABackendRegisterInfo& info) {
+      return info.options.highPriority ? _priorityConnection : _connection;
+    }
+
+    /**
+     * Get the subscription manager of the lane used by the given register. Might be a nullptr if the subscription
+     * support was not activated yet.
+     */
+    std::shared_ptr<OPCUASubscriptionManager>& getSubscriptionManager(const OpcUABackendRegisterInfo& info) {
+      return info.options.highPriority ? _prioritySubscriptionManager : _subscriptionManager;
+    }
+
+    /**
+     * Get the asynchronous writer of the lane used by the given register. It is a nullptr if writes are synchronous.
+     */
+    std::unique_ptr<OPCUAAsyncWriter>& getAsyncWriter(const OpcUABackendRegisterInfo& info) {
+      return info.options.highPriority ? _priorityAsyncWriter : _asyncWriter;
+    }
+
+    /**
+     * Add the accessor to the PubSub subscriber if PubSub is enabled and the register is mapped to a DataSet field.
+     * The subscriber is created on first use and starts receiving when activateAsyncRead() is called.
+     *
+     * \return False if the register is not received via PubSub. In that case the subscription is to be used.
+     */
+    bool subscribePubSub(OpcUABackendRegisterAccessorBase* accessor);
+
+    /**
+     * Remove the accessor from the PubSub subscriber.
+     */
+    void unsubscribePubSub(OpcUABackendRegisterAccessorBase* accessor);
+
+    /**
+     * Start receiving DataSets if the PubSub subscriber is used. Errors are reported via setException().
+     */
+    void activatePubSub() noexcept;
+
+    /**
+     * Add the accessor to the poll scheduler if the register is in poll mode. The scheduler is created on first use and
+     * starts polling when activateAsyncRead() is called.
+     *
+     * \return False if the register is not polled. In that case the subscription is to be used.
+     */
+    bool subscribePoll(OpcUABackendRegisterAccessorBase* accessor);
+
+    /**
+     * Remove the accessor from the poll scheduler.
+     */
+    void unsubscribePoll(OpcUABackendRegisterAccessorBase* accessor);
 
     template<typename UserType>
     boost::shared_ptr<NDRegisterAccessor<UserType>> getRegisterAccessor_impl(
@@ -170,6 +270,30 @@ namespace ChimeraTK {
     std::shared_ptr<OPCUASubscriptionManager> _subscriptionManager;
     std::shared_ptr<OPCUAConnection> _connection;
 
+    /*
+     * The priority lane uses a dedicated client session, subscription and client thread for registers with high
+     * priority. So bulk traffic using the default lane (e.g. synchronous reads of large arrays holding the client lock)
+     * does not delay them. Both are only created if the catalogue includes registers with high priority.
+     */
+    std::shared_ptr<OPCUASubscriptionManager> _prioritySubscriptionManager;
+    std::shared_ptr<OPCUAConnection> _priorityConnection;
+
+    /// Probes the server via the default connection. Only created if enabled by the device parameters.
+    std::unique_ptr<OPCUAHealthMonitor> _healthMonitor;
+
+    /// Send the writes of the default and the priority lane asynchronously. Only created if enabled by the device
+    /// parameters.
+    std::unique_ptr<OPCUAAsyncWriter> _asyncWriter;
+    std::unique_ptr<OPCUAAsyncWriter> _priorityAsyncWriter;
+
+    /// Polls the registers in poll mode via the default connection. Only created if such registers are used.
+    std::unique_ptr<OPCUAPollScheduler> _pollScheduler;
+
+    PubSubSettings _pubSubSettings;
+#ifdef UA_ENABLE_PUBSUB
+    std::unique_ptr<OPCUAPubSubSubscriber> _pubSubSubscriber;
+#endif
+
    private:
     /**
      * Catalogue is filled when device is opened. When working with LogicalNameMapping the
@@ -199,6 +323,37 @@ namespace ChimeraTK {
      */
     void connect();
 
+    /**
+     * Connect the client of the given connection.
+     *
+     * \throws ChimeraTK::runtime_error if the connection fails.
+     */
+    static void connectClient(OPCUAConnection& connection);
+
+    /**
+     * Register the nodes of the catalogue with the RegisterNodes service of the lane they are used with. Called after
+     * connecting, since the aliases are only valid in the session they were registered in.
+     */
+    void registerNodes();
+
+    /**
+     * Create the subscription manager of the given lane if not done yet, activate it and start the client thread.
+     */
+    static void activateLane(
+        std::shared_ptr<OPCUASubscriptionManager>& manager, const std::shared_ptr<OPCUAConnection>& connection);
+
+    /**
+     * Called by the health monitor if the connection is lost or the server restarted. Exceptions with the given
+     * message are pushed to all accessors and the sessions are marked closed, so they are established again in open().
+     * The catalogue is kept, so no browsing is needed after a server restart.
+     */
+    void connectionLost(const std::string& message);
+
+    /**
+     * Get the connection and the subscription manager of the lane the given client belongs to.
+     */
+    std::pair<std::shared_ptr<OPCUAConnection>, std::shared_ptr<OPCUASubscriptionManager>> getLane(UA_Client* client);
+
     /**
      * Reset subscription.
      */
@@ -216,10 +371,41 @@ namespace ChimeraTK {
      * \param nodeName An alternative node name. If not set the nodeName is set to the
      *        name of the node in case of a string node id and to "node_ID", where ID is
      *        the node id, in case of numeric node id.
-     * \param range OPC UA style range definition, e.g. "1,2:3". Here we only consider the first dimension!
+     * \param range OPC UA style range definition, e.g. "2:3" or "1:2,0:9" for two-dimensional nodes.
+     * \param options Register specific options given in the map file.
      */
-    void addCatalogueEntry(
-        const UA_NodeId& node, const std::shared_ptr<std::string>& nodeName = nullptr, const std::string& range = "");
+    void addCatalogueEntry(const UA_NodeId& node, const std::shared_ptr<std::string>& nodeName = nullptr,
+        const std::string& range = "", const OpcUABackendRegisterOptions& options = {});
+
+    /**
+     * Add a register whose channels are the given nodes (channel group). All nodes need the same built-in data type
+     * and the same number of elements. The register is read only if one of the nodes is not writable.
+     */
+    void addChannelGroup(const std::vector<UA_NodeId>& nodes, const std::string& nodeName,
+        const OpcUABackendRegisterOptions& options);
+
+    /**
+     * Add a register for each scalar field of a structure node with the given data type. The fields are named
+     * nodeName/fieldName. Fields of types not supported by the accessors (e.g. arrays) are skipped.
+     */
+    void addStructureEntries(const UA_NodeId& node, const std::string& nodeName, const UA_NodeId& typeId,
+        const std::string& range, const OpcUABackendRegisterOptions& options);
+
+    /**
+     * Get the decoder of the given structure type. It is read from the server if not known yet.
+     *
+     * \remark The client lock has to be held.
+     * \throws ChimeraTK::runtime_error if the type can not be read or is not supported.
+     */
+    std::shared_ptr<const OPCUAStructureType> getStructureType(const UA_NodeId& typeId);
+
+    /**
+     * Set the decoders of the structure registers read from the cache file. Called after connecting.
+     */
+    void resolveStructureTypes();
+
+    /// Decoders of the structure types used by the catalogue.
+    std::vector<std::shared_ptr<const OPCUAStructureType>> _structureTypes;
 
     /**
      * Browse for nodes of type Variable.
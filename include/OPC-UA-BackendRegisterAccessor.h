@@ -10,6 +10,7 @@
  */
 #include "ManagedTypes.h"
 #include "OPC-UA-Backend.h"
+#include "PagedTransfer.h"
 #include "SubscriptionManager.h"
 #include "VersionMapper.h"
 
@@ -25,8 +26,11 @@
 #include <boost/shared_ptr.hpp>
 
 #include <chrono>
+#include <cstring>
 #include <mutex>
 #include <sstream>
+#include <type_traits>
+#include <vector>
 
 namespace fusion = boost::fusion;
 
@@ -70,7 +74,7 @@ namespace ChimeraTK {
   template<typename SourceType>
   class RangeCheckingDataConverter<UA_String, SourceType> {
    public:
-    static UA_String convert(SourceType& x) { return UA_STRING((char*)std::to_string(x).c_str()); }
+    static UA_String convert(SourceType& x) { return UA_String_fromChars(std::to_string(x).c_str()); }
   };
 
   template<typename SourceType>
@@ -153,7 +157,8 @@ namespace ChimeraTK {
   class OpcUABackendRegisterAccessorBase {
    public:
     OpcUABackendRegisterAccessorBase(boost::shared_ptr<OpcUABackend> backend, OpcUABackendRegisterInfo* info)
-    : backend(std::move(backend)), info(info) {}
+    : backend(std::move(backend)), info(info), connection(this->backend->getConnection(*info)),
+      windowStart(info->getRangeStart()), windowLength(info->arrayLength) {}
     // future_queue used to notify the TransferFuture about completed transfers
     cppext::future_queue<ManagedDataValue> notifications;
 
@@ -163,17 +168,51 @@ namespace ChimeraTK {
 
     OpcUABackendRegisterInfo* info;
 
-    bool subscribed{false}; ///< Remember if a subscription was added.
+    std::shared_ptr<OPCUAConnection> connection; ///< Connection of the lane used by the register.
+
+    bool subscribed{false};       ///< Remember if a subscription was added.
+    bool pubSubSubscribed{false}; ///< Remember if the accessor was added to the PubSub subscriber.
+    bool pollSubscribed{false};   ///< Remember if the accessor was added to the poll scheduler.
 
     /*
-     * The subscription manager might use one monitored item for several accessors (e.g. if multiple LogicalNameMappings
-     * are used or a variable is mapped multiple times in the LogicalNameMapping). If an accessors is added to the
-     * accessors list of a MonitorItem the initial value is copied from the first accessor to the new accessor. At this
-     * point it must be ensured that the data of the source accessor is not updated, when reading the inital value. In
-     * consequence the mutex is needed only when an accessor is added and the inital value is forwarded. If only one accessor
-     * is used at all in principle no mutex is needed. But a new accessor can be added in principle at any time.
+     * The subscription manager uses one monitored item for all accessors of the same node (e.g. if multiple
+     * LogicalNameMappings are used or a node is mapped multiple times in the map file with different names or ranges).
+     * The monitored range is the minimal range covering the windows of all accessors, i.e. the register range reduced
+     * to the requested offset and number of words. The window of the node delivered to this accessor is sliced out of
+     * the data of the monitored item.
+     */
+    size_t windowStart; ///< First element of the node delivered to this accessor by the subscription manager
+    size_t windowLength; ///< Number of elements delivered to this accessor by the subscription manager
+
+    /**
+     * Index of the first element of the accessor in each channel of data. Data received from the subscription manager
+     * only contains the accessor window (except for registers that need the full node), data read synchronously
+     * contains the whole register.
      */
-    std::mutex dataUpdateLock;
+    size_t dataOffset{0};
+
+    /**
+     * True if the accessor window is the whole node, i.e. the register has no range and the accessor is not partial.
+     */
+    [[nodiscard]] bool needsFullNode() const {
+      // the elements of ByteString registers are bytes, so windows can not be sliced out of the blobs
+      // the channels of multi-dimensional registers are not contiguous in the node, so the node is not sliced either
+      // channel groups are assembled from several nodes
+      return info->isByteString() || info->isMultiDimensional || info->isChannelGroup() ||
+          (info->indexRange.empty() && windowStart == 0 && windowLength == info->arrayLength);
+    }
+
+    /**
+     * True if the accessor belongs to a history register, which gets the samples collected by the subscription manager.
+     */
+    [[nodiscard]] bool isHistory() const { return info->historyContent != OpcUAHistoryContent::none; }
+
+    /**
+     * Maximum age in ms of values the server may return from its cache, as set for the register or else for the device.
+     */
+    [[nodiscard]] double getMaxAge() const {
+      return info->options.maxAge >= 0 ? info->options.maxAge : connection->maxAge;
+    }
 
     myMap m{fusion::make_pair<UA_Int16>(UA_TYPES[UA_TYPES_INT16]),
         fusion::make_pair<UA_UInt16>(UA_TYPES[UA_TYPES_UINT16]), fusion::make_pair<UA_Int32>(UA_TYPES[UA_TYPES_INT32]),
@@ -260,8 +299,135 @@ namespace ChimeraTK {
     RangeCheckingDataConverter<CTKType, UAType> toCTK;
     bool isPartial{false};
 
+    /**
+     * True if writes cover the whole register, so the value to be written is built from the accessor buffer without
+     * reading the node first. Not the case for partial accessors, ranges, ByteStrings (number and sizes of the blobs
+     * are kept) and multi-dimensional nodes (the dimensions are kept).
+     */
+    bool isFullCoverage{false};
+
+    /**
+     * Maximum number of elements per read request if the accessor is too large for a single message received by the
+     * client, else 0. In that case the elements are read in pages.
+     */
+    size_t readPageSize{0};
+
+    /**
+     * Maximum number of elements per write request if the accessor is too large for a single message sent to the
+     * server, else 0. In that case the elements are written in pages.
+     */
+    size_t writePageSize{0};
+
    private:
     void handleError(const UA_StatusCode& retval);
+
+    /**
+     * Requests built once in the constructor, so synchronous reads and writes do not assemble them. Only the node ids
+     * (the aliases of the current session) and the values are set per transfer. There is one entry per node, i.e. one
+     * per channel for channel groups. The requests refer to the entries and the index range of the register info, so
+     * the accessor must not be copied.
+     */
+    std::vector<UA_ReadValueId> readIds;
+    UA_ReadRequest readRequest;
+    std::vector<UA_WriteValue> writeValues;
+    UA_WriteRequest writeRequest;
+
+    /**
+     * Build the read and write requests.
+     */
+    void prepareRequests();
+
+    /**
+     * Fill data with the accessor buffer for a write covering the whole register. The variant held by data is reused if
+     * it has the right shape already, so no memory is allocated in that case.
+     *
+     * \param scalar If true the value is written as scalar, else as array.
+     */
+    void fillWriteValue(bool scalar);
+
+    /**
+     * Set the element of data to the element of the accessor buffer. Strings of std::string accessors are not copied
+     * but refer to the characters of the accessor buffer, so they have to be released by releaseStrings() before data
+     * is used otherwise.
+     */
+    void setElement(UAType& element, size_t channel, size_t i);
+
+    /**
+     * Reset the strings of data referring to the accessor buffer, so they are not freed when clearing data.
+     */
+    void releaseStrings();
+
+    bool stringsBorrowed{false}; ///< True if strings of data refer to the accessor buffer
+
+    /**
+     * Releases the strings borrowed from the accessor buffer when leaving the scope.
+     */
+    struct BorrowedStrings {
+      OpcUABackendRegisterAccessor* accessor;
+      ~BorrowedStrings() { accessor->releaseStrings(); }
+    };
+
+    /**
+     * Write data to the node. Registers of a range of a multi-dimensional node only write their rows and columns.
+     *
+     * \remark The client lock has to be held.
+     */
+    UA_StatusCode writeValue();
+
+    /**
+     * Read all nodes of a channel group with a single request and assemble them in data.
+     *
+     * \remark The client lock has to be held.
+     * \return The first bad status code of the request or of a node.
+     */
+    UA_StatusCode readChannels();
+
+    /**
+     * Write data to all nodes of a channel group with a single request. Channels of one element are written as
+     * scalars.
+     *
+     * \remark The client lock has to be held.
+     * \return The first bad status code of the request or of a node.
+     */
+    UA_StatusCode writeChannels();
+
+    /**
+     * Throw a logic_error if the node is not writable, else handle the error like handleError().
+     */
+    void handleWriteError(const UA_StatusCode& retval);
+
+    /**
+     * Read the accessor elements in pages into pageBuffer, which is swapped with the accessor buffer in doPostRead().
+     */
+    void readPages();
+
+    /**
+     * Write the accessor elements in pages. Only the accessor elements are written, so no read is needed before.
+     */
+    void writePages();
+
+    std::vector<CTKType> pageBuffer; ///< Elements read in pages
+    bool pagesRead{false};           ///< True if the last read was done in pages
+    UA_DateTime pageSourceTime{0};   ///< Newest source time stamp of the pages read
+
+    /**
+     * Copy the field of the structure in data to the accessor buffer. Data received from the subscription manager is
+     * decoded already, data read synchronously or polled is decoded here.
+     */
+    void readStructureField();
+
+    /**
+     * Copy the bytes of the ByteString in data to the accessor buffer. Only used for ByteString registers, which are
+     * accessed with UAType UA_Byte.
+     */
+    void readByteString();
+
+    /**
+     * Copy the accessor buffer to the bytes of the ByteString in data. Only used for ByteString registers.
+     *
+     * \throws ChimeraTK::runtime_error if the size of the ByteString does not match the register any more.
+     */
+    void writeByteString();
   };
 
   template<typename UAType, typename CTKType>
@@ -275,52 +441,127 @@ namespace ChimeraTK {
       throw ChimeraTK::logic_error("Raw access mode is not supported.");
     }
 
-    NDRegisterAccessor<CTKType>::buffer_2D.resize(1);
-    this->accessChannel(0).resize(numberOfWords);
+    NDRegisterAccessor<CTKType>::buffer_2D.resize(info->numberOfChannels);
+    for(auto& channel : NDRegisterAccessor<CTKType>::buffer_2D) {
+      channel.resize(numberOfWords);
+    }
+    windowStart += wordOffsetInRegister;
+    windowLength = numberOfWords;
     if(flags.has(AccessMode::wait_for_new_data)) {
       UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Adding subscription for node: %s",
           info->nodeBrowseName.c_str());
-      // Create notification queue.
-      notifications = cppext::future_queue<ManagedDataValue>(3);
+      // Create notification queue. It has to hold all samples backfilled from the history after a reconnect.
+      notifications = cppext::future_queue<ManagedDataValue>(std::max<size_t>(3, info->options.backfillLength + 1));
       _readQueue = notifications.then<void>(
           [this](ManagedDataValue& data) {
-            std::lock_guard<std::mutex> lock(dataUpdateLock);
             if(!data.hasValue()) {
               throw ChimeraTK::runtime_error("No data in found in the data queue.");
             }
             this->data = std::move(data);
+            dataOffset = needsFullNode() ? offsetWords : 0;
           },
           std::launch::deferred);
-      if(!backend->_subscriptionManager) {
-        backend->activateSubscriptionSupport();
+      if(backend->subscribePubSub(this)) {
+        pubSubSubscribed = true;
       }
-      backend->_subscriptionManager->subscribe(info->nodeBrowseName, info->id, this);
-      if(backend->_subscriptionManager->isAsyncReadActive()) {
-        if(backend->_subscriptionManager->opcuaThread == nullptr) {
-          backend->_subscriptionManager->start();
-          // sleep twice the publishing interval to make sure initial values are written
-          std::this_thread::sleep_for(
-              std::chrono::milliseconds(2 * (uint32_t)backend->_connection->publishingInterval));
+      else if(backend->subscribePoll(this)) {
+        pollSubscribed = true;
+      }
+      else {
+        auto& subscriptionManager = backend->getSubscriptionManager(*info);
+        if(!subscriptionManager) {
+          backend->activateSubscriptionSupport(*info);
+        }
+        subscriptionManager->subscribe(info->nodeBrowseName, info->id, this);
+        if(subscriptionManager->isAsyncReadActive()) {
+          if(subscriptionManager->opcuaThread == nullptr) {
+            subscriptionManager->start();
+            // initial values not read by the subscription manager are sent with the first publish response
+            subscriptionManager->waitForInitialValues();
+          }
         }
+        subscribed = true;
       }
-      subscribed = true;
     }
     if(info->arrayLength != numberOfWords) {
       isPartial = true;
     }
+    isFullCoverage = !isPartial && info->indexRange.empty() && !info->isByteString() && !info->isMultiDimensional &&
+        !info->isStructureField();
+    if(!info->isByteString() && !info->isMultiDimensional && !info->isChannelGroup()) {
+      // arrays larger than a message of the connection are transferred in pages - the limits of both directions differ
+      const UA_DataType* type = &fusion::at_key<UAType>(m);
+      size_t elements = OPCUAPagedTransfer::getReadPageSize(*connection, type);
+      if(elements > 0 && numberOfWords > elements) {
+        readPageSize = elements;
+      }
+      // arrays read in pages are written in pages as well, since pages do not need to read the array before writing
+      elements = OPCUAPagedTransfer::getWritePageSize(*connection, type);
+      if(elements > 0 && (numberOfWords > elements || readPageSize > 0)) {
+        writePageSize = elements;
+      }
+      if(readPageSize > 0 || writePageSize > 0) {
+        UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Transferring node %s in pages of %zu elements (read) and %zu elements (write, 0 = no pages).",
+            info->nodeBrowseName.c_str(), readPageSize, writePageSize);
+      }
+    }
+    prepareRequests();
     NDRegisterAccessor<CTKType>::_exceptionBackend = backend;
   }
 
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::prepareRequests() {
+    size_t nNodes = info->isChannelGroup() ? info->channelIds.size() : 1;
+    readIds.resize(nNodes);
+    writeValues.resize(nNodes);
+    for(size_t i = 0; i < nNodes; ++i) {
+      UA_ReadValueId_init(&readIds[i]);
+      readIds[i].attributeId = UA_ATTRIBUTEID_VALUE;
+      UA_WriteValue_init(&writeValues[i]);
+      writeValues[i].attributeId = UA_ATTRIBUTEID_VALUE;
+      writeValues[i].value.hasValue = true;
+    }
+    if(info->isMultiDimensional && !info->indexRange.empty()) {
+      // the range is only borrowed
+      writeValues[0].indexRange = UA_STRING(const_cast<char*>(info->indexRange.c_str()));
+    }
+    UA_ReadRequest_init(&readRequest);
+    readRequest.nodesToRead = readIds.data();
+    readRequest.nodesToReadSize = nNodes;
+    readRequest.maxAge = getMaxAge();
+    if(info->isChannelGroup()) {
+      readRequest.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    }
+    UA_WriteRequest_init(&writeRequest);
+    writeRequest.nodesToWrite = writeValues.data();
+    writeRequest.nodesToWriteSize = nNodes;
+  }
+
   template<typename UAType, typename CTKType>
   void OpcUABackendRegisterAccessor<UAType, CTKType>::doReadTransferSynchronously() {
     backend->checkActiveException();
-    std::lock_guard<std::mutex> lock(backend->_connection->client_lock);
-    std::shared_ptr<ManagedVariant> val(new ManagedVariant());
-    UA_StatusCode retval = UA_Client_readValueAttribute(backend->_connection->client.get(), info->id, val->var);
+    if(readPageSize > 0) {
+      readPages();
+      return;
+    }
+    if(info->isChannelGroup()) {
+      std::lock_guard<std::mutex> lock(connection->client_lock);
+      UA_StatusCode retval = readChannels();
+      if(retval != UA_STATUSCODE_GOOD) {
+        handleError(retval);
+      }
+      dataOffset = offsetWords;
+      return;
+    }
+    // concurrent reads of the same node are merged
+    UA_StatusCode retval = connection->readValue(
+        info->id, readRequest, [this](const UA_Variant& value) { data.copyVariant(value, info->indexRange); });
     if(retval != UA_STATUSCODE_GOOD) {
+      std::lock_guard<std::mutex> lock(connection->client_lock);
       handleError(retval);
     }
-    data.copyVariant(*val->var, info->indexRange);
+    dataOffset = offsetWords;
   }
 
   template<typename UAType, typename CTKType>
@@ -328,18 +569,43 @@ namespace ChimeraTK {
     if(!hasNewData) {
       return;
     }
+    if(pagesRead) {
+      // the pages were converted already
+      pagesRead = false;
+      this->buffer_2D[0].swap(pageBuffer);
+      this->setDataValidity(DataValidity::ok);
+      currentVersion = VersionMapper::getInstance().getVersion(pageSourceTime);
+      TransferElement::_versionNumber = currentVersion;
+      return;
+    }
     // check if no data is present -> nullptr
     if(!data.hasValue()) {
       UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Data status error for node: %s Error: %s",
           info->nodeBrowseName.c_str(), UA_StatusCode_name(data.getStatus()));
       this->setDataValidity(DataValidity::faulty);
     }
+    else if(info->isByteString()) {
+      readByteString();
+    }
+    else if(info->isStructureField()) {
+      readStructureField();
+    }
     else {
       UAType* tmp = (UAType*)(data.getValue());
-      for(size_t i = 0; i < numberOfWords; i++) {
-        UAType value = tmp[offsetWords + i];
-        // Fill the NDRegisterAccessor buffer
-        this->accessData(i) = toCTK.convert(value);
+      // the channels are the rows of the data in row major order, so they are filled without reshaping the data
+      for(size_t channel = 0; channel < this->buffer_2D.size(); channel++) {
+        UAType* row = tmp + channel * info->arrayLength + dataOffset;
+        for(size_t i = 0; i < numberOfWords; i++) {
+          if constexpr(std::is_same_v<UAType, UA_String> && std::is_same_v<CTKType, std::string>) {
+            // assigned in place, so the capacity of the accessor buffer is reused
+            this->accessData(channel, i).assign(reinterpret_cast<const char*>(row[i].data), row[i].length);
+          }
+          else {
+            UAType value = row[i];
+            // Fill the NDRegisterAccessor buffer
+            this->accessData(channel, i) = toCTK.convert(value);
+          }
+        }
       }
       this->setDataValidity(DataValidity::ok);
     }
@@ -350,31 +616,314 @@ namespace ChimeraTK {
   template<typename UAType, typename CTKType>
   bool OpcUABackendRegisterAccessor<UAType, CTKType>::doWriteTransfer(ChimeraTK::VersionNumber versionNumber) {
     backend->checkActiveException();
-    // create empty array
-    if(isPartial || !data.hasValue()) {
+    auto& writer = backend->getAsyncWriter(*info);
+    bool isAsync = writer && writer->isRunning();
+    if(writePageSize > 0) {
+      if(isAsync) {
+        // pages are written synchronously, but not before the writes already queued
+        writer->waitUntilWritten(info->id);
+      }
+      writePages();
+      currentVersion = versionNumber;
+      return false;
+    }
+    // It is not known before the first transfer if a node of one element is a scalar or an array. So it is read once,
+    // since servers accepting both (value rank any) would silently turn the array into a scalar.
+    bool unknownShape = isFullCoverage && !data.hasValue() && info->arrayLength == 1 && !info->isChannelGroup();
+    if((!isFullCoverage && (isPartial || !data.hasValue())) || unknownShape) {
+      if(isAsync) {
+        // the read has to include the writes of this node that are not confirmed yet
+        writer->waitUntilWritten(info->id);
+      }
       // read array first before changing only relevant parts of it
       OpcUABackendRegisterAccessor<UAType, CTKType>::doReadTransferSynchronously();
     }
-    for(size_t i = 0; i < numberOfWords; i++) {
-      // avoid memory leak and clear the entries to be overwritten here
-      UA_clear(&(((UAType*)data.getValue())[offsetWords + i]), &fusion::at_key<UAType>(m));
-      ((UAType*)data.getValue())[offsetWords + i] = toOpcUA.convert(this->accessData(i));
+    // strings borrowed from the accessor buffer are released after the transfer, also if it throws
+    BorrowedStrings borrowed{this};
+    if(info->isByteString()) {
+      writeByteString();
     }
-    std::lock_guard<std::mutex> lock(backend->_connection->client_lock);
-    UA_StatusCode retval =
-        UA_Client_writeValueAttribute(backend->_connection->client.get(), info->id, data.getVariant());
+    else if(isFullCoverage) {
+      // nodes of more than one element are arrays
+      fillWriteValue(data.hasValue() && UA_Variant_isScalar(data.getVariant()));
+    }
+    else {
+      for(size_t channel = 0; channel < this->buffer_2D.size(); channel++) {
+        UAType* row = (UAType*)data.getValue() + channel * info->arrayLength + dataOffset;
+        for(size_t i = 0; i < numberOfWords; i++) {
+          setElement(row[i], channel, i);
+        }
+      }
+    }
+    // all nodes of a channel group are written with a single request, so they are not written asynchronously
+    if(isAsync && !info->isChannelGroup()) {
+      // registers of a range of a multi-dimensional node only write their rows and columns
+      std::string writeRange = info->isMultiDimensional ? info->indexRange : std::string();
+      // fire and forget - a failed write is reported via setException() and by the next write
+      writer->write(info->id, *data.getVariant(), info->nodeBrowseName, writeRange);
+      currentVersion = versionNumber;
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(connection->client_lock);
+    UA_StatusCode retval = info->isChannelGroup() ? writeChannels() : writeValue();
     currentVersion = versionNumber;
     if(retval == UA_STATUSCODE_GOOD) {
       return true;
     }
+    handleWriteError(retval);
+    return false;
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::fillWriteValue(bool scalar) {
+    // the channels of a channel group are the rows of data
+    size_t length = info->numberOfChannels * info->arrayLength;
+    if(data.allocate(&fusion::at_key<UAType>(m), length, scalar) != UA_STATUSCODE_GOOD) {
+      throw ChimeraTK::runtime_error(
+          std::string("OPC-UA-Backend::Failed to allocate the value to be written to variable: ") + node_id);
+    }
+    dataOffset = 0;
+    auto* values = static_cast<UAType*>(data.getValue());
+    for(size_t channel = 0; channel < this->buffer_2D.size(); channel++) {
+      UAType* row = values + channel * info->arrayLength;
+      for(size_t i = 0; i < numberOfWords; i++) {
+        setElement(row[i], channel, i);
+      }
+    }
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::setElement(UAType& element, size_t channel, size_t i) {
+    if constexpr(std::is_same_v<UAType, UA_String>) {
+      // only strings hold memory that has to be freed before overwriting them
+      UA_String_clear(&element);
+      if constexpr(std::is_same_v<CTKType, std::string>) {
+        // the characters are encoded directly from the accessor buffer
+        std::string& value = this->accessData(channel, i);
+        element.length = value.size();
+        element.data = reinterpret_cast<UA_Byte*>(value.data());
+        stringsBorrowed = true;
+        return;
+      }
+    }
+    element = toOpcUA.convert(this->accessData(channel, i));
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::releaseStrings() {
+    if constexpr(std::is_same_v<UAType, UA_String>) {
+      if(!stringsBorrowed) {
+        return;
+      }
+      stringsBorrowed = false;
+      for(size_t channel = 0; channel < this->buffer_2D.size(); channel++) {
+        UAType* row = (UAType*)data.getValue() + channel * info->arrayLength + dataOffset;
+        for(size_t i = 0; i < numberOfWords; i++) {
+          UA_String_init(&row[i]);
+        }
+      }
+    }
+  }
+
+  template<typename UAType, typename CTKType>
+  UA_StatusCode OpcUABackendRegisterAccessor<UAType, CTKType>::writeValue() {
+    // node and value are only borrowed
+    writeValues[0].nodeId = connection->resolve(info->id);
+    writeValues[0].value.value = *data.getVariant();
+    UA_WriteResponse response = UA_Client_Service_write(connection->client.get(), writeRequest);
+    UA_StatusCode retval = response.responseHeader.serviceResult;
+    if(retval == UA_STATUSCODE_GOOD) {
+      retval = response.resultsSize == 1 ? response.results[0] : UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    UA_WriteResponse_clear(&response);
+    return retval;
+  }
+
+  template<typename UAType, typename CTKType>
+  UA_StatusCode OpcUABackendRegisterAccessor<UAType, CTKType>::readChannels() {
+    const UA_DataType* type = &fusion::at_key<UAType>(m);
+    size_t nChannels = info->channelIds.size();
+    for(size_t i = 0; i < nChannels; ++i) {
+      // the node ids are only borrowed
+      readIds[i].nodeId = connection->resolve(info->channelIds[i]);
+    }
+    UA_ReadResponse response = UA_Client_Service_read(connection->client.get(), readRequest);
+    UA_StatusCode retval = response.responseHeader.serviceResult;
+    if(retval == UA_STATUSCODE_GOOD && response.resultsSize != nChannels) {
+      retval = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    // the nodes are copied one after another like the rows of a two-dimensional node
+    ManagedDataValue channels;
+    for(size_t i = 0; retval == UA_STATUSCODE_GOOD && i < nChannels; ++i) {
+      const UA_DataValue& result = response.results[i];
+      if(result.hasStatus && result.status != UA_STATUSCODE_GOOD) {
+        retval = result.status;
+      }
+      else if(!result.hasValue || result.value.type != type) {
+        retval = UA_STATUSCODE_BADTYPEMISMATCH;
+      }
+      else {
+        retval = channels.setRange(&result, i * info->arrayLength, nChannels * info->arrayLength);
+      }
+    }
+    UA_ReadResponse_clear(&response);
+    if(retval == UA_STATUSCODE_GOOD) {
+      data = std::move(channels);
+    }
+    return retval;
+  }
+
+  template<typename UAType, typename CTKType>
+  UA_StatusCode OpcUABackendRegisterAccessor<UAType, CTKType>::writeChannels() {
+    const UA_DataType* type = &fusion::at_key<UAType>(m);
+    size_t nChannels = info->channelIds.size();
+    for(size_t i = 0; i < nChannels; ++i) {
+      // nodes and values are only borrowed
+      writeValues[i].nodeId = connection->resolve(info->channelIds[i]);
+      UAType* row = (UAType*)data.getValue() + i * info->arrayLength;
+      if(info->arrayLength == 1) {
+        UA_Variant_setScalar(&writeValues[i].value.value, row, type);
+      }
+      else {
+        UA_Variant_setArray(&writeValues[i].value.value, row, info->arrayLength, type);
+      }
+    }
+    UA_WriteResponse response = UA_Client_Service_write(connection->client.get(), writeRequest);
+    UA_StatusCode retval = response.responseHeader.serviceResult;
+    if(retval == UA_STATUSCODE_GOOD && response.resultsSize != nChannels) {
+      retval = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    for(size_t i = 0; retval == UA_STATUSCODE_GOOD && i < nChannels; ++i) {
+      retval = response.results[i];
+    }
+    UA_WriteResponse_clear(&response);
+    return retval;
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::handleWriteError(const UA_StatusCode& retval) {
     if(retval == UA_STATUSCODE_BADNOTWRITABLE || retval == UA_STATUSCODE_BADWRITENOTSUPPORTED) {
-      if(backend->_subscriptionManager) {
-        backend->_subscriptionManager->setExternalError(info->nodeBrowseName);
+      if(backend->getSubscriptionManager(*info)) {
+        backend->getSubscriptionManager(*info)->setExternalError(info->id);
       }
       throw ChimeraTK::logic_error(std::string("OPC-UA-Backend::Variable ") + node_id + " is not writable!");
     }
     handleError(retval);
-    return false;
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::readPages() {
+    pageBuffer.resize(numberOfWords);
+    pageSourceTime = 0;
+    const UA_DataType* type = &fusion::at_key<UAType>(m);
+    std::lock_guard<std::mutex> lock(connection->client_lock);
+    OPCUAPagedTransfer transfer(
+        *connection, connection->resolve(info->id), info->getRangeStart() + offsetWords, numberOfWords, readPageSize);
+    UA_StatusCode retval = transfer.read(getMaxAge(), [&](size_t offset, const UA_DataValue& page) -> UA_StatusCode {
+      if(page.value.type != type) {
+        return UA_STATUSCODE_BADTYPEMISMATCH;
+      }
+      size_t count = UA_Variant_isScalar(&page.value) ? 1 : page.value.arrayLength;
+      auto* values = static_cast<UAType*>(page.value.data);
+      for(size_t i = 0; i < count && offset + i < numberOfWords; ++i) {
+        UAType value = values[i];
+        pageBuffer[offset + i] = toCTK.convert(value);
+      }
+      UA_DateTime sourceTime = page.hasSourceTimestamp ? page.sourceTimestamp : UA_DateTime_now();
+      pageSourceTime = std::max(pageSourceTime, sourceTime);
+      return UA_STATUSCODE_GOOD;
+    });
+    if(retval != UA_STATUSCODE_GOOD) {
+      handleError(retval);
+    }
+    pagesRead = true;
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::writePages() {
+    std::lock_guard<std::mutex> lock(connection->client_lock);
+    OPCUAPagedTransfer transfer(
+        *connection, connection->resolve(info->id), info->getRangeStart() + offsetWords, numberOfWords, writePageSize);
+    UA_StatusCode retval =
+        transfer.write(&fusion::at_key<UAType>(m), [&](size_t offset, size_t count, void* array) {
+          auto* values = static_cast<UAType*>(array);
+          for(size_t i = 0; i < count; ++i) {
+            values[i] = toOpcUA.convert(this->accessData(offset + i));
+          }
+        });
+    if(retval != UA_STATUSCODE_GOOD) {
+      handleWriteError(retval);
+    }
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::readStructureField() {
+    const void* field = nullptr;
+    if(info->structure && info->structure->decode(*data.getVariant()) == UA_STATUSCODE_GOOD) {
+      field = info->structure->getField(*data.getVariant(), info->structureField);
+    }
+    if(field == nullptr) {
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed to decode structure of node: %s.", info->nodeBrowseName.c_str());
+      this->setDataValidity(DataValidity::faulty);
+      return;
+    }
+    UAType value = *static_cast<const UAType*>(field);
+    this->accessData(0) = toCTK.convert(value);
+    this->setDataValidity(DataValidity::ok);
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::readByteString() {
+    if constexpr(std::is_same_v<UAType, UA_Byte>) {
+      size_t copied = forEachByteStringSegment(
+          *data.getVariant(), dataOffset, numberOfWords, [&](const UA_Byte* bytes, size_t index, size_t count) {
+            if constexpr(std::is_same_v<CTKType, uint8_t>) {
+              // no conversion needed - the bytes are copied as a whole
+              std::memcpy(&this->accessData(index), bytes, count);
+            }
+            else {
+              for(size_t i = 0; i < count; ++i) {
+                UA_Byte value = bytes[i];
+                this->accessData(index + i) = toCTK.convert(value);
+              }
+            }
+          });
+      if(copied == numberOfWords) {
+        this->setDataValidity(DataValidity::ok);
+        return;
+      }
+      // the blob is shorter than when the catalogue was created
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "ByteString of node: %s has %zu bytes instead of %zu.", info->nodeBrowseName.c_str(), dataOffset + copied,
+          dataOffset + numberOfWords);
+      for(size_t i = copied; i < numberOfWords; ++i) {
+        this->accessData(i) = CTKType();
+      }
+      this->setDataValidity(DataValidity::faulty);
+    }
+  }
+
+  template<typename UAType, typename CTKType>
+  void OpcUABackendRegisterAccessor<UAType, CTKType>::writeByteString() {
+    if constexpr(std::is_same_v<UAType, UA_Byte>) {
+      // the blobs read before are modified in place, so their number and sizes are kept
+      size_t copied = forEachByteStringSegment(
+          *data.getVariant(), dataOffset, numberOfWords, [&](UA_Byte* bytes, size_t index, size_t count) {
+            if constexpr(std::is_same_v<CTKType, uint8_t>) {
+              std::memcpy(bytes, &this->accessData(index), count);
+            }
+            else {
+              for(size_t i = 0; i < count; ++i) {
+                bytes[i] = toOpcUA.convert(this->accessData(index + i));
+              }
+            }
+          });
+      if(copied != numberOfWords) {
+        throw ChimeraTK::runtime_error(std::string("OPC-UA-Backend::Size of ByteString variable: ") + node_id +
+            " changed on the server.");
+      }
+    }
   }
 
   template<typename UAType, typename CTKType>
@@ -382,18 +931,24 @@ namespace ChimeraTK {
     std::stringstream out;
     out << "OPC-UA-Backend::Failed to access variable: " << node_id << " with reason: " << UA_StatusCode_name(retval)
         << " --> " << std::hex << retval;
-    if(backend->_subscriptionManager) {
-      backend->_subscriptionManager->setExternalError(info->nodeBrowseName);
+    if(backend->getSubscriptionManager(*info)) {
+      backend->getSubscriptionManager(*info)->setExternalError(info->id);
     }
     // close connection on error
-    backend->_connection->close();
+    connection->close();
     throw ChimeraTK::runtime_error(out.str());
   }
 
   template<typename UAType, typename CTKType>
   OpcUABackendRegisterAccessor<UAType, CTKType>::~OpcUABackendRegisterAccessor() {
     if(subscribed) {
-      backend->_subscriptionManager->unsubscribe(info->nodeBrowseName, this);
+      backend->getSubscriptionManager(*info)->unsubscribe(info->id, this);
+    }
+    if(pubSubSubscribed) {
+      backend->unsubscribePubSub(this);
+    }
+    if(pollSubscribed) {
+      backend->unsubscribePoll(this);
     }
   }
 } // namespace ChimeraTK
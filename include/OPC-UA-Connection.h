@@ -7,6 +7,8 @@
  *  Created on: Jan 29, 2021
  *      Author: Klaus Zenker (HZDR)
  */
+#include "ManagedTypes.h"
+
 #include <open62541/client_config_default.h>
 #include <open62541/client_highlevel.h>
 #include <open62541/plugin/certificategroup_default.h>
@@ -16,12 +18,17 @@
 #include <dirent.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace ChimeraTK {
 
@@ -29,6 +36,31 @@ namespace ChimeraTK {
     void operator()(UA_Client* client) { UA_Client_delete(client); }
   };
 
+  /**
+   * Tuning parameters of the OPC UA subscription.
+   *
+   * For the subscription parameters a value of 0 means the parameter is derived by the OPCUASubscriptionManager from
+   * the number of monitored items and the round trip time measured when the subscription is created.
+   */
+  struct SubscriptionSettings {
+    UA_UInt16 publishRequests{0};            ///< Number of publish requests the client keeps outstanding
+    UA_UInt32 maxNotificationsPerPublish{0}; ///< Maximum number of notifications in a single publish response
+    UA_UInt32 lifetimeCount{0};              ///< Number of publishing intervals without publish request from the client
+                                             ///< before the server deletes the subscription
+    UA_UInt32 maxKeepAliveCount{0}; ///< Number of publishing intervals without notification before a keep alive is sent
+    UA_UInt32 itemGracePeriod{0};   ///< Time in ms monitored items without accessors are kept for reuse. If 0 they are
+                                    ///< removed immediately.
+    UA_UInt32 maxPooledItems{1000}; ///< Maximum number of monitored items without accessors kept for reuse
+  };
+
+  struct NodeIdHash {
+    size_t operator()(const UA_NodeId& node) const { return UA_NodeId_hash(&node); }
+  };
+
+  struct NodeIdEqual {
+    bool operator()(const UA_NodeId& a, const UA_NodeId& b) const { return UA_NodeId_equal(&a, &b); }
+  };
+
   struct OPCUAConnection {
     // This needs to be public because it is accessed by the RegisterAccessor.
     // Can not be a shared pointer because the struct is only defined in the source file...
@@ -56,6 +88,39 @@ namespace ChimeraTK {
     unsigned long publishingInterval;
     unsigned long connectionTimeout;
 
+    SubscriptionSettings subscriptionSettings;
+
+    /**
+     * Real-time priority (SCHED_FIFO) of the thread running the subscription of this connection. If 0 the default
+     * scheduling is used.
+     */
+    int realtimePriority{0};
+
+    /**
+     * Round trip time in ms of the last call to measureRoundTripTime().
+     */
+    double roundTripTime{0};
+
+    /**
+     * Maximum age in ms of values the server may return from its cache for synchronous reads, i.e. the server does not
+     * need to read the value from the underlying device. Can be overwritten per register in the map file.
+     */
+    double maxAge{0};
+
+    /**
+     * Number of reads served by readValue() without sending a request, because a read of the same node was in flight.
+     */
+    std::atomic<size_t> mergedReads{0};
+
+    /**
+     * If true the nodes of the catalogue are registered with the RegisterNodes service after connecting and the aliases
+     * returned by the server are used for reading, writing and monitoring.
+     */
+    bool useRegisteredNodes{true};
+
+    /// Maximum number of nodes registered with a single RegisterNodes request.
+    static constexpr size_t registerNodesBatchSize{1000};
+
     UA_Logger logger;
 
     OPCUAConnection(const std::string& address, const std::string& username, const std::string& password,
@@ -107,6 +172,8 @@ namespace ChimeraTK {
       config->timeout = connectionTimeout;
     };
 
+    ~OPCUAConnection() { clearRegisteredNodes(); }
+
     void close() {
       auto ret = UA_Client_disconnect(client.get());
       if(ret != UA_STATUSCODE_GOOD) {
@@ -115,12 +182,226 @@ namespace ChimeraTK {
       }
     }
 
+    /**
+     * Measure the round trip time by reading the server state.
+     * The result is stored in roundTripTime.
+     *
+     * \remark The client lock has to be held when calling this method.
+     */
+    void measureRoundTripTime() {
+      UA_Variant* val = UA_Variant_new();
+      auto start = std::chrono::steady_clock::now();
+      UA_StatusCode ret = UA_Client_readValueAttribute(client.get(), UA_NS0ID(SERVER_SERVERSTATUS_STATE), val);
+      auto stop = std::chrono::steady_clock::now();
+      UA_Variant_delete(val);
+      if(ret != UA_STATUSCODE_GOOD) {
+        UA_LOG_WARNING(config->logging, UA_LOGCATEGORY_USERLAND,
+            "Failed to measure the round trip time. Error: %s", UA_StatusCode_name(ret));
+        return;
+      }
+      roundTripTime = std::chrono::duration<double, std::milli>(stop - start).count();
+    }
+
+    /**
+     * Read the value attribute of the given node. If a read of the same node is in flight already no second request is
+     * sent, but the result of the running read is shared (single flight). So accessors of the same node read at the
+     * same time, e.g. by several modules or LogicalNameMapping devices, do not queue up on the client lock.
+     *
+     * The request is pre-built by the caller with a single UA_ReadValueId for the value attribute. Only its node id is
+     * set to the alias of node before sending, so no request is assembled per read. Neither the request nor the
+     * bookkeeping of the reads in flight allocate memory.
+     *
+     * \param node The node to be read.
+     * \param request The request to be sent. Its maxAge is the maximum age in ms of a value the server may return from
+     *                its cache. A read is only merged into a read in flight with the same or a smaller maximum age, so
+     *                reads that must not get cached values are not served by reads that accept them.
+     * \param onValue Called with the value if the read succeeded. The value is only valid during the call.
+     * Only reads that did not get their response yet are merged, so a read started after a write completed always
+     * gets a value that includes the write.
+     *
+     * \remark The client lock must not be held when calling this method.
+     */
+    template<typename Function>
+    UA_StatusCode readValue(const UA_NodeId& node, UA_ReadRequest& request, Function onValue) {
+      PendingRead read{&node, request.maxAge};
+      {
+        std::unique_lock<std::mutex> lock(_readLock);
+        for(PendingRead* other = _pendingReads; other != nullptr; other = other->next) {
+          if(UA_NodeId_equal(other->node, &node) && other->maxAge <= request.maxAge) {
+            ++mergedReads;
+            return waitForRead(*other, lock, onValue);
+          }
+        }
+        read.next = _pendingReads;
+        _pendingReads = &read;
+      }
+      UA_ReadResponse response;
+      {
+        std::lock_guard<std::mutex> lock(client_lock);
+        // the node id is only borrowed
+        request.nodesToRead[0].nodeId = resolve(node);
+        response = UA_Client_Service_read(client.get(), request);
+        // Stop merging before releasing the client lock. Else a write completed after this read could be followed by a
+        // read that is merged into this one and gets the value from before the write.
+        std::lock_guard<std::mutex> readLock(_readLock);
+        for(PendingRead** it = &_pendingReads; *it != nullptr; it = &(*it)->next) {
+          if(*it == &read) {
+            *it = read.next;
+            break;
+          }
+        }
+      }
+      UA_StatusCode status = response.responseHeader.serviceResult;
+      if(status == UA_STATUSCODE_GOOD && response.resultsSize != 1) {
+        status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+      }
+      if(status == UA_STATUSCODE_GOOD) {
+        // same checks as done by UA_Client_readValueAttribute
+        const UA_DataValue& result = response.results[0];
+        if(result.hasStatus && result.status != UA_STATUSCODE_GOOD) {
+          status = result.status;
+        }
+        else if(!result.hasValue) {
+          status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+        }
+        else {
+          read.value = &result.value;
+          onValue(result.value);
+        }
+      }
+      {
+        std::unique_lock<std::mutex> lock(_readLock);
+        read.status = status;
+        read.done = true;
+        _readDone.notify_all();
+        // the merged readers refer to read and to the value of the response
+        _readDone.wait(lock, [&] { return read.waiters == 0; });
+      }
+      UA_ReadResponse_clear(&response);
+      return status;
+    }
+
+    /**
+     * Register the given nodes with the RegisterNodes service in batches of registerNodesBatchSize and store the
+     * aliases returned by the server. Aliases of a previous session are dropped. If the server does not support the
+     * service, the nodes are used as they are.
+     *
+     * \remark The client lock has to be held when calling this method.
+     */
+    void registerNodes(std::vector<UA_NodeId>& nodes) {
+      clearRegisteredNodes();
+      if(!useRegisteredNodes) {
+        return;
+      }
+      for(size_t first = 0; first < nodes.size(); first += registerNodesBatchSize) {
+        UA_RegisterNodesRequest request;
+        UA_RegisterNodesRequest_init(&request);
+        // the node ids are only borrowed
+        request.nodesToRegister = nodes.data() + first;
+        request.nodesToRegisterSize = std::min(registerNodesBatchSize, nodes.size() - first);
+        UA_RegisterNodesResponse response = UA_Client_Service_registerNodes(client.get(), request);
+        UA_StatusCode status = response.responseHeader.serviceResult;
+        if(status == UA_STATUSCODE_GOOD && response.registeredNodeIdsSize != request.nodesToRegisterSize) {
+          status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+        }
+        if(status != UA_STATUSCODE_GOOD) {
+          UA_RegisterNodesResponse_clear(&response);
+          UA_LOG_INFO(config->logging, UA_LOGCATEGORY_USERLAND,
+              "Failed to register nodes (%s). Using the node ids of the catalogue.", UA_StatusCode_name(status));
+          clearRegisteredNodes();
+          return;
+        }
+        for(size_t i = 0; i < response.registeredNodeIdsSize; ++i) {
+          if(UA_NodeId_equal(&request.nodesToRegister[i], &response.registeredNodeIds[i])) {
+            // no alias provided by the server
+            continue;
+          }
+          UA_NodeId node;
+          UA_NodeId_copy(&request.nodesToRegister[i], &node);
+          // the alias is taken over from the response
+          registeredNodes.emplace(node, response.registeredNodeIds[i]);
+          UA_NodeId_init(&response.registeredNodeIds[i]);
+        }
+        UA_RegisterNodesResponse_clear(&response);
+      }
+      UA_LOG_INFO(config->logging, UA_LOGCATEGORY_USERLAND, "Registered %zu nodes, the server provided %zu aliases.",
+          nodes.size(), registeredNodes.size());
+    }
+
+    /**
+     * Get the alias of the given node registered in the current session, or the node itself if it is not registered.
+     *
+     * \remark The client lock has to be held while the returned node id is used.
+     */
+    const UA_NodeId& resolve(const UA_NodeId& node) const {
+      if(registeredNodes.empty()) {
+        return node;
+      }
+      auto it = registeredNodes.find(node);
+      return it == registeredNodes.end() ? node : it->second;
+    }
+
+    /**
+     * Drop the aliases of the registered nodes, e.g. because the session is closed. They are not unregistered on the
+     * server, since they are only valid in the session anyway.
+     *
+     * \remark The client lock has to be held when calling this method.
+     */
+    void clearRegisteredNodes() {
+      for(auto& [node, alias] : registeredNodes) {
+        UA_NodeId_clear(const_cast<UA_NodeId*>(&node));
+        UA_NodeId_clear(&alias);
+      }
+      registeredNodes.clear();
+    }
+
     // Check connection state set by the callback function.
     bool isConnected() const {
       return (sessionState == UA_SESSIONSTATE_ACTIVATED && channelState == UA_SECURECHANNELSTATE_OPEN);
     }
 
    private:
+    /**
+     * Read in flight. It lives on the stack of the caller of readValue() that sent the request, which also owns the
+     * node id and the value.
+     */
+    struct PendingRead {
+      const UA_NodeId* node;
+      double maxAge; ///< Maximum age of the request
+      PendingRead* next{nullptr};
+      const UA_Variant* value{nullptr}; ///< Value of the response, only set if the read succeeded
+      UA_StatusCode status{UA_STATUSCODE_GOOD};
+      bool done{false};  ///< True once the response is processed
+      size_t waiters{0}; ///< Number of merged readers that did not get the value yet
+    };
+
+    /**
+     * Wait for the given read in flight and pass its value to onValue. The lock of _readLock has to be held.
+     */
+    template<typename Function>
+    UA_StatusCode waitForRead(PendingRead& read, std::unique_lock<std::mutex>& lock, Function& onValue) {
+      ++read.waiters;
+      _readDone.wait(lock, [&] { return read.done; });
+      UA_StatusCode status = read.status;
+      lock.unlock();
+      // the sender keeps the value until all waiters are done
+      if(status == UA_STATUSCODE_GOOD) {
+        onValue(*read.value);
+      }
+      lock.lock();
+      if(--read.waiters == 0) {
+        _readDone.notify_all();
+      }
+      return status;
+    }
+
+    PendingRead* _pendingReads{nullptr}; ///< Intrusive list of the reads in flight
+    std::mutex _readLock;                ///< Protects _pendingReads and the members of the reads in flight
+    std::condition_variable _readDone;   ///< Notified when a read in flight is done or its last waiter is served
+
+    /// Aliases returned by the RegisterNodes service in the current session. Protected by the client lock.
+    std::unordered_map<UA_NodeId, UA_NodeId, NodeIdHash, NodeIdEqual> registeredNodes;
+
     /**
      * loadFile parses the certificate file.
      *
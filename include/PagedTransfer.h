@@ -0,0 +1,135 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+/*
+ * PagedTransfer.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include "OPC-UA-Connection.h"
+
+#include <open62541/types.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ChimeraTK {
+
+  /**
+   * Reads or writes elements of a large array node in pages using index ranges, so no message exceeds the message size
+   * limits of the connection. Up to maxPagesInFlight requests are sent before waiting for the responses (pipelining),
+   * so the memory used is bounded by the page size and not by the array size.
+   *
+   * The pages are not transferred atomically, i.e. other clients might see an array that is partially written.
+   */
+  class OPCUAPagedTransfer {
+   public:
+    /**
+     * \param connection Connection used for the transfer. The client lock has to be held while using the object.
+     * \param node Node to be transferred. It is only borrowed.
+     * \param start First element of the node to be transferred.
+     * \param length Number of elements to be transferred.
+     * \param pageSize Maximum number of elements per request.
+     */
+    OPCUAPagedTransfer(
+        OPCUAConnection& connection, const UA_NodeId& node, size_t start, size_t length, size_t pageSize);
+    OPCUAPagedTransfer(const OPCUAPagedTransfer&) = delete;
+    OPCUAPagedTransfer& operator=(const OPCUAPagedTransfer&) = delete;
+
+    /**
+     * Read the elements. onPage is called for each page with the index of its first element relative to start in the
+     * order the responses arrive. If it returns a bad status code no more pages are sent and it is not called for the
+     * pages still in flight.
+     *
+     * \remark The client lock has to be held.
+     * \return The first bad status code of a request, page or of onPage.
+     */
+    UA_StatusCode read(double maxAge, const std::function<UA_StatusCode(size_t, const UA_DataValue&)>& onPage);
+
+    /**
+     * Write the elements. fillPage(offset, count, array) is called for each page to fill the array of count elements of
+     * the given type with the elements starting at offset relative to start. The array is freed after sending it.
+     *
+     * \remark The client lock has to be held.
+     * \return The first bad status code of a request or page.
+     */
+    UA_StatusCode write(const UA_DataType* type, const std::function<void(size_t, size_t, void*)>& fillPage);
+
+    /**
+     * Get the maximum number of elements of the given type that fit into a message received by the client. This is
+     * derived from the message size and chunk limits of the client connection, which bound the limits negotiated with
+     * the server.
+     *
+     * \return 0 if the connection has no limits or the size of the elements is not fixed (e.g. strings), i.e. arrays
+     *         of the type are not to be read in pages.
+     */
+    static size_t getReadPageSize(const OPCUAConnection& connection, const UA_DataType* type);
+
+    /**
+     * Get the maximum number of elements of the given type that fit into a message sent to the server. The limits
+     * announced by the server when connecting are not available via the client API of open62541. So the remote limits
+     * of the client configuration are used, bounded by maxServerMessageSize.
+     *
+     * \return 0 if the size of the elements is not fixed (e.g. strings), i.e. arrays of the type are not to be written
+     *         in pages.
+     */
+    static size_t getWritePageSize(const OPCUAConnection& connection, const UA_DataType* type);
+
+    /// Message size assumed to be accepted by servers, i.e. the default limit of the OPC Foundation .NET stack.
+    static constexpr size_t maxServerMessageSize{4 * 1024 * 1024};
+
+    /// Maximum number of requests in flight.
+    static constexpr size_t maxPagesInFlight{4};
+
+    /// Bytes of a message reserved for headers, node id and index range.
+    static constexpr size_t messageOverhead{1024};
+
+   private:
+    /**
+     * Page sent or to be sent.
+     */
+    struct Page {
+      OPCUAPagedTransfer* transfer;
+      size_t offset; ///< First element relative to start
+      size_t count;  ///< Number of elements
+    };
+
+    /**
+     * Send the pages using send and process the responses until all pages are completed. After a page failed no more
+     * pages are sent, but the pages in flight are still completed. Only if a response times out or the connection
+     * fails, the connection is closed to abort the requests in flight, since their callbacks refer to this object.
+     */
+    UA_StatusCode transfer(const std::function<UA_StatusCode(Page&)>& send);
+
+    /**
+     * Index range string of the page in the node, e.g. "100:199".
+     */
+    [[nodiscard]] std::string getRange(const Page& page) const;
+
+    static void readCallback(UA_Client* client, void* userdata, UA_UInt32 requestId, UA_ReadResponse* response);
+
+    static void writeCallback(UA_Client* client, void* userdata, UA_UInt32 requestId, UA_WriteResponse* response);
+
+    /**
+     * Count the page as completed and keep the first bad status code.
+     */
+    void complete(UA_StatusCode status);
+
+    /**
+     * Get the maximum number of elements of the given type that fit into a message with the given limits (0 means
+     * unbounded).
+     */
+    static size_t getPageSize(size_t maxMessageSize, size_t chunkSize, size_t maxChunkCount, const UA_DataType* type);
+
+    OPCUAConnection& _connection;
+    const UA_NodeId& _node;
+    size_t _start;
+    std::vector<Page> _pages;
+    size_t _inFlight{0};
+    UA_StatusCode _status{UA_STATUSCODE_GOOD};
+
+    /// Called for the pages read. Only set while reading.
+    const std::function<UA_StatusCode(size_t, const UA_DataValue&)>* _onPage{nullptr};
+  };
+} // namespace ChimeraTK
@@ -0,0 +1,185 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+/*
+ * PollScheduler.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include "ManagedTypes.h"
+#include "OPC-UA-Connection.h"
+
+#include <open62541/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ChimeraTK {
+  class OpcUABackendRegisterAccessorBase;
+
+  /**
+   * Node polled with a certain interval. All accessors of registers mapping the same node and range with the same poll
+   * interval share the item.
+   */
+  struct PollItem {
+    UA_NodeId node;         ///< Node id of the process variable to be polled
+    std::string indexRange; ///< Range read from the server. Empty if the whole node is read.
+    size_t rangeStart{0};   ///< First element of the node that is read
+    UA_UInt32 interval{0};  ///< Poll interval in ticks of the timing wheel
+    size_t rounds{0};       ///< Number of wheel revolutions left before the item is due
+    double maxAge{0};       ///< Maximum age in ms of values read from the server cache (smallest of all accessors)
+    std::string browseName; ///< browseName of the register that created the item - only used for logging
+    std::vector<OpcUABackendRegisterAccessorBase*> accessors; ///< Pointer to the accessors using this item
+    ManagedDataValue lastValue; ///< Last value read. Used to detect changes and for accessors added later.
+    size_t id{0}; ///< Unique id. A new item might get the address of a removed one, so pointers are checked by the id.
+
+    PollItem(const OpcUABackendRegisterAccessorBase* accessor, UA_UInt32 interval);
+    PollItem(const PollItem&) = delete;
+    PollItem& operator=(const PollItem&) = delete;
+    ~PollItem();
+
+    /**
+     * True if the item reads the same node and range as the given item, i.e. both can be served by the same read.
+     */
+    [[nodiscard]] bool readsSame(const PollItem& other) const {
+      return indexRange == other.indexRange && UA_NodeId_equal(&node, &other.node);
+    }
+
+    /**
+     * Push the window of the given value belonging to the given accessor to the accessor.
+     */
+    void push(const UA_DataValue* value, OpcUABackendRegisterAccessorBase* accessor) const;
+  };
+
+  /**
+   * Reads registers in poll mode periodically and pushes changed values to the accessors, like the subscription manager
+   * does with received notifications. This is used for servers that do not allow to monitor all nodes, e.g. because of
+   * limited monitored item quotas.
+   *
+   * The items are scheduled using a hashed timing wheel with a resolution of tickInterval. In each tick all due items
+   * are read with a single read request. Items reading the same node and range (e.g. registers with different poll
+   * intervals) share a single entry in the request. Values are only pushed to the accessors if value or status
+   * changed. The maximum age of the request is the smallest maximum age of the due items.
+   */
+  class OPCUAPollScheduler {
+   public:
+    explicit OPCUAPollScheduler(std::shared_ptr<OPCUAConnection> connection);
+    ~OPCUAPollScheduler();
+
+    /**
+     * Add the accessor to the item of its node and poll interval. If polling is active and the item has a value
+     * already it is pushed to the accessor, else the item is read in the next tick.
+     */
+    void subscribe(OpcUABackendRegisterAccessorBase* accessor);
+
+    /**
+     * Remove the accessor. If it was the last accessor of the item, the item is not polled any more.
+     */
+    void unsubscribe(OpcUABackendRegisterAccessorBase* accessor);
+
+    /**
+     * Start polling if not running yet. All items are read in the first tick and their values are pushed to the
+     * accessors.
+     */
+    void activate();
+
+    /**
+     * Stop polling. If a message is given and polling was active, an exception with this message is pushed to all
+     * accessors.
+     */
+    void deactivate(const std::string& message);
+
+    [[nodiscard]] bool isActive() const { return _run; }
+
+    /// Resolution of the timing wheel. Shorter poll intervals are rounded up to one tick.
+    static constexpr std::chrono::milliseconds tickInterval{10};
+
+    /// Number of slots of the timing wheel. Longer intervals take several revolutions.
+    static constexpr size_t wheelSize{512};
+
+   private:
+    /// Item taken from the wheel and its id, which tells if the pointer still refers to the same item.
+    using DueItem = std::pair<PollItem*, size_t>;
+
+    /**
+     * Put the item into the slot of the wheel it is due in after the given number of ticks (at least 1).
+     *
+     * \remark Lock needs to be held.
+     */
+    void schedule(PollItem* item, size_t ticks);
+
+    /**
+     * Remove the item from the wheel.
+     *
+     * \remark Lock needs to be held.
+     */
+    void unschedule(PollItem* item);
+
+    /**
+     * Advance the wheel by one tick and collect the items that are due. The items are scheduled again.
+     *
+     * \remark Lock needs to be held.
+     */
+    void advance(std::vector<DueItem>& due);
+
+    /**
+     * Read the given items with a single request and push the changed values to the accessors. Items removed in the
+     * meantime are skipped.
+     *
+     * \param items Items taken from the wheel.
+     * \param removals Value of _removals when the items were taken from the wheel.
+     * \remark It holds the client lock and the lock, but not at the same time.
+     * \return False if the request failed. In that case an exception is pushed to all accessors.
+     */
+    bool poll(const std::vector<DueItem>& items, size_t removals);
+
+    /**
+     * True if the item with the given id is still in the list of items, i.e. the pointer taken from the wheel is valid.
+     *
+     * \remark Lock needs to be held.
+     */
+    [[nodiscard]] bool isKnown(const PollItem* item, size_t id) const;
+
+    /**
+     * Push an exception with the given message to all accessors.
+     *
+     * \remark Lock needs to be held.
+     */
+    void pushException(const std::string& message);
+
+    /**
+     * Poll loop. Launched in a separate thread by activate().
+     */
+    void run();
+
+    std::shared_ptr<OPCUAConnection> _connection;
+
+    /// Items to be polled - a list is used because the wheel keeps pointers to the items
+    std::list<PollItem> _items;
+
+    /// Items sorted by the slot they are due in next.
+    std::vector<std::vector<PollItem*>> _wheel;
+
+    /// Slot of the last tick.
+    size_t _currentSlot{0};
+
+    /// Number of items removed so far. Used to skip checking the items read if none was removed while reading.
+    size_t _removals{0};
+
+    /// Id of the item added last.
+    size_t _lastItemId{0};
+
+    std::unique_ptr<std::thread> _thread;
+    std::atomic<bool> _run{false};
+    std::mutex _mutex; ///< Protects the items and the wheel
+    std::condition_variable _stopCondition;
+  };
+} // namespace ChimeraTK
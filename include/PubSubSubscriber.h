@@ -0,0 +1,155 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+/*
+ * PubSubSubscriber.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include "ManagedTypes.h"
+#include "RegisterInfo.h"
+
+#include <open62541/types.h>
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef UA_ENABLE_PUBSUB
+#  include <open62541/server.h>
+#endif
+
+namespace ChimeraTK {
+  class OpcUABackendRegisterAccessorBase;
+
+  /**
+   * Settings of the PubSub subscriber given as device parameters.
+   */
+  struct PubSubSettings {
+    std::string url;              ///< Address the DataSets are received on, e.g. opc.udp://224.0.0.22:4840/
+    std::string networkInterface; ///< Network interface used to receive. If empty the default interface is used.
+
+    [[nodiscard]] bool enabled() const { return !url.empty(); }
+  };
+
+#ifdef UA_ENABLE_PUBSUB
+  class OPCUAPubSubSubscriber;
+
+  struct UAServerDeleter {
+    void operator()(UA_Server* server) { UA_Server_delete(server); }
+  };
+
+  /**
+   * Field of a DataSet received via PubSub. All accessors of registers mapped to the field get the received values.
+   */
+  struct PubSubField {
+    UA_UInt32 dataType{0};      ///< Data type as given in the catalogue (0 if no register is mapped to the field)
+    size_t arrayLength{1};      ///< Array length as given in the catalogue
+    UA_NodeId targetNode{};     ///< Node in the local server the DataSetReader writes the field to
+    std::vector<OpcUABackendRegisterAccessorBase*> accessors; ///< Accessors of registers mapped to the field
+    OPCUAPubSubSubscriber* subscriber{nullptr};               ///< Subscriber owning the field
+  };
+
+  /**
+   * Receives DataSets published via OPC UA PubSub (UADP over UDP) and pushes the fields to the accessors. This avoids
+   * the publish request round trips of the client subscription for fast signals.
+   *
+   * PubSub is only available in the open62541 server API, so a local server without endpoints is used. One
+   * DataSetReader is created for each DataSet referenced in the register catalogue (publisherId, writerGroupId,
+   * dataSetWriterId). The fields are written to variables of the local server, whose write callbacks push the values to
+   * the accessor queues.
+   */
+  class OPCUAPubSubSubscriber {
+   public:
+    OPCUAPubSubSubscriber(const PubSubSettings& settings, const OpcUaBackendRegisterCatalogue& catalogue);
+    ~OPCUAPubSubSubscriber();
+
+    /**
+     * Add the accessor to the field its register is mapped to.
+     *
+     * \throws ChimeraTK::logic_error if the field was not in the catalogue when the subscriber was created.
+     */
+    void subscribe(OpcUABackendRegisterAccessorBase* accessor);
+
+    /**
+     * Remove the accessor from the field its register is mapped to.
+     */
+    void unsubscribe(OpcUABackendRegisterAccessorBase* accessor);
+
+    /**
+     * Set up the local server and the DataSetReaders if not done yet and start receiving DataSets.
+     *
+     * \throws ChimeraTK::runtime_error if the PubSub connection can not be created. The exception is pushed to all
+     * accessors as well.
+     */
+    void activate();
+
+    /**
+     * Stop receiving DataSets. If a message is given and the subscriber was active, an exception with this message is
+     * pushed to all accessors.
+     */
+    void deactivate(const std::string& message);
+
+    [[nodiscard]] bool isActive() const { return _run; }
+
+   private:
+    /// Publisher id, writer group id and DataSetWriter id identifying a DataSet.
+    using DataSetKey = std::tuple<UA_UInt16, UA_UInt16, UA_UInt16>;
+
+    static DataSetKey getKey(const OpcUABackendRegisterOptions& options) {
+      return {options.publisherId, options.writerGroupId, options.dataSetWriterId};
+    }
+
+    /**
+     * Create the local server, the PubSub connection, the reader group and one DataSetReader per DataSet.
+     *
+     * \throws ChimeraTK::runtime_error if the PubSub connection can not be created.
+     */
+    void setupServer();
+
+    /**
+     * Add the DataSetReader and the target variables for the given DataSet. If that fails the reader and the target
+     * variables added so far are removed again and the DataSet is not received.
+     */
+    void addReader(const DataSetKey& key, std::vector<PubSubField>& fields);
+
+    /**
+     * Get the field the register with the given options is mapped to. Returns a nullptr if it is not known.
+     *
+     * \remark _mutex needs to be held.
+     */
+    PubSubField* findField(const OpcUABackendRegisterOptions& options);
+
+    /**
+     * Push an exception with the given message to all accessors.
+     */
+    void pushException(const std::string& message);
+
+    /**
+     * Run the local server. Launched in a separate thread by activate().
+     */
+    void run();
+
+    /// Callback of the target variables - pushes the received field to the accessors.
+    static void onWrite(UA_Server* server, const UA_NodeId* sessionId, void* sessionContext, const UA_NodeId* nodeId,
+        void* nodeContext, const UA_NumericRange* range, const UA_DataValue* data);
+
+    PubSubSettings _settings;
+
+    /// Fields of all DataSets referenced in the catalogue. The field index is the position in the vector.
+    std::map<DataSetKey, std::vector<PubSubField>> _dataSets;
+
+    std::unique_ptr<UA_Server, UAServerDeleter> _server;
+    UA_NodeId _readerGroupId;
+
+    std::unique_ptr<std::thread> _thread;
+    std::atomic<bool> _run{false};
+    std::mutex _mutex; ///< Protects the accessors of the fields
+  };
+#endif
+} // namespace ChimeraTK
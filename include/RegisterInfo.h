@@ -5,6 +5,9 @@
 #include <ChimeraTK/BackendRegisterCatalogue.h>
 
 #include <open62541/client_highlevel.h>
+
+#include <memory>
+#include <vector>
 /*
  * RegisterInfo.h
  *
@@ -12,14 +15,95 @@
  *      Author: Klaus Zenker (HZDR)
  */
 namespace ChimeraTK {
+  class OPCUAStructureType;
+
+  /**
+   * Aggregate delivered by a register instead of the individual samples. Arrays are aggregated element wise.
+   */
+  enum class OpcUAAggregateType { none, min, max, mean, last, count };
+
+  /**
+   * Convert the aggregate type to the name used in the map file.
+   */
+  std::string toString(const OpcUAAggregateType& type);
+
+  /**
+   * Convert the name used in the map file to the aggregate type.
+   *
+   * \throws std::invalid_argument if the name is unknown.
+   */
+  OpcUAAggregateType aggregateFromString(const std::string& name);
+
+  /**
+   * Register specific options that can be set in the xml map file. They are stored in the cache file as well.
+   */
+  struct OpcUABackendRegisterOptions {
+    size_t chunkSize{0}; ///< Number of array elements per monitored item. If 0 the node is monitored by a single item.
+    size_t historyLength{0}; ///< Number of samples kept in the history registers. If 0 no history registers are added.
+    OpcUAAggregateType aggregate{OpcUAAggregateType::none}; ///< Aggregate delivered instead of the samples
+    double aggregateInterval{0}; ///< Length of the aggregation window in ms
+    size_t aggregateSamples{0};  ///< Number of samples per aggregate. If not 0 it is used instead of the interval.
+    UA_UInt16 publisherId{0};     ///< PubSub publisher id of the DataSet the register is received with
+    UA_UInt16 writerGroupId{0};   ///< PubSub writer group id of the DataSet the register is received with
+    UA_UInt16 dataSetWriterId{0}; ///< PubSub DataSetWriter id. If 0 the register is not received via PubSub.
+    size_t dataSetField{0};       ///< Index of the field in the DataSet
+    bool highPriority{false};     ///< If true the register uses the priority lane, i.e. a dedicated client session
+    size_t backfillLength{0}; ///< Maximum number of samples read from the server history after a reconnect (0 = off)
+    UA_UInt32 pollInterval{0}; ///< Poll interval in ms. If not 0 the register is polled instead of monitored.
+    double maxAge{-1}; ///< Maximum age in ms of values read from the server cache (negative = device setting)
+
+    /**
+     * True if the register gets the same aggregate as a register with the given options.
+     */
+    [[nodiscard]] bool sameAggregate(const OpcUABackendRegisterOptions& other) const {
+      return aggregate == other.aggregate && aggregateInterval == other.aggregateInterval &&
+          aggregateSamples == other.aggregateSamples;
+    }
+
+    /**
+     * True if the register is received via PubSub instead of the client subscription if PubSub is enabled.
+     */
+    [[nodiscard]] bool usesPubSub() const { return dataSetWriterId != 0; }
+
+    /**
+     * True if the register is read periodically by the poll scheduler instead of being monitored by the subscription.
+     */
+    [[nodiscard]] bool usesPolling() const { return pollInterval != 0; }
+  };
+
+  /**
+   * Content of a register. History registers deliver the last samples of a scalar node received via the subscription
+   * as array. The timestamps register contains the source time stamps of the samples in ns since the Unix epoch.
+   */
+  enum class OpcUAHistoryContent { none, values, timestamps };
+
   class OpcUABackendRegisterInfo;
   class OpcUaBackendRegisterCatalogue : public ChimeraTK::BackendRegisterCatalogue<OpcUABackendRegisterInfo> {
    public:
     // Add all registers for the given property. Registers which exist already in the catalogue (with the same name) are
-    // skipped.
+    // skipped. numberOfChannels is the number of rows of a two-dimensional node (or of its range) and 0 for nodes with
+    // one dimension. In that case arrayLength is the number of elements per row.
     void addProperty(const UA_NodeId& node, const std::string& browseName, const std::string& range,
         const UA_UInt32& dataType, const size_t& arrayLength, const std::string& serverAddress,
-        const std::string& description, const bool& isReadonly);
+        const std::string& description, const bool& isReadonly, const OpcUABackendRegisterOptions& options = {},
+        const OpcUAHistoryContent& history = OpcUAHistoryContent::none, const size_t& numberOfChannels = 0);
+
+    // Add the read only register of a field of a structure node. structure is the decoder of the structure type. It is
+    // not set if the catalogue is read from the cache file - in that case it is set by the backend after connecting.
+    void addStructureField(const UA_NodeId& node, const std::string& browseName, const UA_UInt32& dataType,
+        const std::string& serverAddress, const std::string& description, const OpcUABackendRegisterOptions& options,
+        const std::string& structureType, const size_t& structureField,
+        const std::shared_ptr<const OPCUAStructureType>& structure);
+
+    // Add a register whose channels are the given nodes (channel group). All nodes have the same data type and
+    // arrayLength elements (1 for scalar nodes). The first node identifies the register.
+    void addChannelGroup(const std::vector<UA_NodeId>& nodes, const std::string& browseName, const UA_UInt32& dataType,
+        const size_t& arrayLength, const std::string& serverAddress, const std::string& description,
+        const bool& isReadonly, const OpcUABackendRegisterOptions& options = {});
+
+   private:
+    // Set the data descriptor according to the data type of the entry. Returns false if the data type is not supported.
+    static bool setDataDescriptor(OpcUABackendRegisterInfo& entry);
   };
 
   /**
@@ -46,15 +130,22 @@ namespace ChimeraTK {
 
     OpcUABackendRegisterInfo() = default;
 
-    ~OpcUABackendRegisterInfo() override { UA_NodeId_clear(&id); }
+    ~OpcUABackendRegisterInfo() override {
+      UA_NodeId_clear(&id);
+      clearChannelIds();
+    }
 
     OpcUABackendRegisterInfo(const OpcUABackendRegisterInfo& other)
     : path(other.path), serverAddress(other.serverAddress), nodeBrowseName(other.nodeBrowseName),
       description(other.description), unit(other.unit), dataType(other.dataType), dataDescriptor(other.dataDescriptor),
       isReadonly(other.isReadonly), isNumeric(other.isNumeric), arrayLength(other.arrayLength),
-      accessModes(other.accessModes), indexRange(other.indexRange), namespaceIndex(other.namespaceIndex) {
+      numberOfChannels(other.numberOfChannels), isMultiDimensional(other.isMultiDimensional),
+      accessModes(other.accessModes), indexRange(other.indexRange), namespaceIndex(other.namespaceIndex),
+      options(other.options), historyContent(other.historyContent), structureType(other.structureType),
+      structureField(other.structureField), structure(other.structure) {
       UA_NodeId_init(&id);
       UA_NodeId_copy(&other.id, &id);
+      copyChannelIds(other);
     }
 
     OpcUABackendRegisterInfo& operator=(const OpcUABackendRegisterInfo& other) {
@@ -68,10 +159,18 @@ namespace ChimeraTK {
       isReadonly = other.isReadonly;
       isNumeric = other.isNumeric; //?< Needed for caching
       arrayLength = other.arrayLength;
+      numberOfChannels = other.numberOfChannels;
+      isMultiDimensional = other.isMultiDimensional;
       accessModes = other.accessModes;
       indexRange = other.indexRange;
       namespaceIndex = other.namespaceIndex; //?< Needed for caching
+      options = other.options;
+      historyContent = other.historyContent;
+      structureType = other.structureType;
+      structureField = other.structureField;
+      structure = other.structure;
       UA_NodeId_copy(&other.id, &id);
+      copyChannelIds(other);
       return *this;
     }
 
@@ -81,7 +180,7 @@ namespace ChimeraTK {
 
     unsigned int getNumberOfElements() const override { return arrayLength; }
 
-    unsigned int getNumberOfChannels() const override { return 1; }
+    unsigned int getNumberOfChannels() const override { return numberOfChannels; }
 
     const DataDescriptor& getDataDescriptor() const override { return dataDescriptor; }
 
@@ -91,6 +190,36 @@ namespace ChimeraTK {
 
     AccessModeFlags getSupportedAccessModes() const override { return accessModes; }
 
+    /**
+     * True if the register data is only available via the subscription, e.g. history and aggregate registers.
+     */
+    [[nodiscard]] bool isSubscriptionOnly() const {
+      return historyContent != OpcUAHistoryContent::none || options.aggregate != OpcUAAggregateType::none;
+    }
+
+    /**
+     * True if the node is a ByteString (scalar or array). The elements of the register are the bytes of all blobs one
+     * after another.
+     */
+    [[nodiscard]] bool isByteString() const { return dataType == 15; }
+
+    /**
+     * True if the register is a field of a structure node. All fields of the node are decoded from the same
+     * ExtensionObject, so they share the monitored item and get the same version number.
+     */
+    [[nodiscard]] bool isStructureField() const { return !structureType.empty(); }
+
+    /**
+     * True if the channels of the register are several nodes (channel group). The data of the register holds the nodes
+     * one after another like the rows of a two-dimensional node.
+     */
+    [[nodiscard]] bool isChannelGroup() const { return !channelIds.empty(); }
+
+    /**
+     * First element of the node that belongs to the register. It is 0 if no indexRange is set.
+     */
+    size_t getRangeStart() const;
+
     std::unique_ptr<BackendRegisterInfoBase> clone() const override {
       return std::unique_ptr<BackendRegisterInfoBase>(new OpcUABackendRegisterInfo(*this));
     }
@@ -105,9 +234,37 @@ namespace ChimeraTK {
     bool isReadonly{true};
     bool isNumeric{true};
     uint16_t namespaceIndex{0};
-    size_t arrayLength{0};
+    size_t arrayLength{0};       ///< Number of elements per channel
+    size_t numberOfChannels{1}; ///< Number of rows of a two-dimensional node or of its range
+    /**
+     * True if the node has two dimensions. The data of the register is the range of the node in row major order, i.e.
+     * the elements of one channel follow each other.
+     */
+    bool isMultiDimensional{false};
     AccessModeFlags accessModes{};
     UA_NodeId id{};
     std::string indexRange{""};
+    OpcUABackendRegisterOptions options{};
+    OpcUAHistoryContent historyContent{OpcUAHistoryContent::none};
+    std::string structureType; ///< Data type node of a structure node (e.g. "ns=2;i=3002"), empty for other nodes
+    size_t structureField{0};  ///< Index of the field in the structure
+    std::shared_ptr<const OPCUAStructureType> structure; ///< Decoder of the structure - shared by all its fields
+    std::vector<UA_NodeId> channelIds; ///< Nodes of the channels of a channel group, empty for other registers
+
+   private:
+    void copyChannelIds(const OpcUABackendRegisterInfo& other) {
+      clearChannelIds();
+      channelIds.resize(other.channelIds.size());
+      for(size_t i = 0; i < channelIds.size(); ++i) {
+        UA_NodeId_copy(&other.channelIds[i], &channelIds[i]);
+      }
+    }
+
+    void clearChannelIds() {
+      for(auto& node : channelIds) {
+        UA_NodeId_clear(&node);
+      }
+      channelIds.clear();
+    }
   };
 } // namespace ChimeraTK
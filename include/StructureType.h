@@ -0,0 +1,78 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+/*
+ * StructureType.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+#include "OPC-UA-Connection.h"
+
+#include <open62541/types.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ChimeraTK {
+
+  /**
+   * Decoder of a structure data type of the server, which is not known to the client. The type is built at runtime from
+   * the DataTypeDefinition attribute of the data type node, so the ExtensionObjects received for nodes of that type can
+   * be decoded by open62541.
+   *
+   * Only plain structures are supported, i.e. no optional fields, unions or nested structures. The fields have to be
+   * built-in types, either scalars or arrays.
+   */
+  class OPCUAStructureType {
+   public:
+    /**
+     * Field of the structure.
+     */
+    struct Field {
+      std::string name;
+      const UA_DataType* type; ///< Built-in type of the field
+      size_t offset;           ///< Position of the field in the decoded structure
+      bool isArray;
+    };
+
+    /**
+     * \throws ChimeraTK::runtime_error if the structure is not supported.
+     */
+    OPCUAStructureType(const UA_NodeId& typeId, const UA_StructureDefinition& definition);
+    ~OPCUAStructureType();
+    OPCUAStructureType(const OPCUAStructureType&) = delete;
+    OPCUAStructureType& operator=(const OPCUAStructureType&) = delete;
+
+    /**
+     * Read the DataTypeDefinition of the given data type from the server and create the decoder.
+     *
+     * \remark The client lock has to be held.
+     * \throws ChimeraTK::runtime_error if the definition can not be read or the structure is not supported.
+     */
+    static std::shared_ptr<OPCUAStructureType> read(OPCUAConnection& connection, const UA_NodeId& typeId);
+
+    /**
+     * Replace the encoded ExtensionObject in the given variant by the decoded structure. Nothing is done if the variant
+     * holds the decoded structure already. The decoded variant refers to this object, so it has to be cleared before
+     * this object is destroyed.
+     */
+    UA_StatusCode decode(UA_Variant& variant) const;
+
+    /**
+     * Get the field with the given index of the decoded structure in the variant.
+     *
+     * \return nullptr if the variant does not hold a decoded structure of this type.
+     */
+    [[nodiscard]] const void* getField(const UA_Variant& variant, size_t field) const;
+
+    [[nodiscard]] const std::vector<Field>& getFields() const { return _fields; }
+
+    [[nodiscard]] const UA_NodeId& getTypeId() const { return _type.typeId; }
+
+   private:
+    UA_DataType _type{};
+    std::vector<UA_DataTypeMember> _members;
+    std::vector<Field> _fields;
+  };
+} // namespace ChimeraTK
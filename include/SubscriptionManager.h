@@ -7,14 +7,20 @@
  *  Created on: Dec 17, 2020
  *      Author: Klaus Zenker (HZDR)
  */
+#include "ManagedTypes.h"
 #include "OPC-UA-Backend.h"
 #include "OPC-UA-Connection.h"
+#include "RegisterInfo.h"
 
 #include <open62541/plugin/log_stdout.h>
 #include <open62541/types.h>
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <list>
 #include <map>
 #include <mutex>
 #include <thread>
@@ -23,26 +29,206 @@
 namespace ChimeraTK {
   class OpcUABackendRegisterAccessorBase;
 
+  /**
+   * Part of the monitored range of a node that is monitored by a single OPC UA monitored item.
+   */
+  struct MonitorChunk {
+    size_t start;         ///< First element of the chunk relative to the monitored range
+    size_t length;        ///< Number of elements in the chunk
+    UA_UInt32 id{0};      ///< ID of the monitored item that belongs to the subscription
+    bool received{false}; ///< True if data was received since the monitored item was created
+  };
+
+  /**
+   * State of an aggregate (e.g. the mean over a time window) computed for a monitored item. If the server supports the
+   * requested aggregate an AggregateFilter is used and the server only sends the reduced values. Else all samples are
+   * requested and the aggregate is computed element-wise by the backend.
+   */
+  struct MonitorAggregate {
+    OpcUABackendRegisterOptions settings; ///< Aggregate type and window as given in the map file
+    bool onServer{false};                 ///< True if the aggregate is computed by the server (AggregateFilter)
+    size_t count{0};                      ///< Number of samples in the current window
+    std::vector<double> min;              ///< Element-wise minimum of the current window
+    std::vector<double> max;              ///< Element-wise maximum of the current window
+    std::vector<double> sum;              ///< Element-wise sum of the current window
+    ManagedDataValue last;                ///< Last sample of the current window
+    std::chrono::steady_clock::time_point windowStart; ///< Time the first sample of the current window was received
+  };
+
   /**
    * Struct used to store all information about a backend subscription, which is a monitored item belonging to a OPC UA
    * subscription in terms of OPC UA.
+   *
+   * Items are identified by the node id. If several catalogue entries refer to the same node (e.g. renamed entries or
+   * different ranges of the same array in the map file) a single monitored item is used, which monitors the range
+   * covering the ranges of all accessors. Each accessor gets its window sliced out of the received data. The range of
+   * an item is only changed while it is not monitored: if an accessor whose window is not covered is added to a
+   * monitored item, the item is replaced by a new item covering the windows of all accessors. The accessors of the old
+   * item do not get the initial value of the new item if it has the same source time stamp as the last value of the
+   * old item, and the old item is removed by the client thread. Likewise an item is replaced by one with a reduced
+   * range when accessors are removed, if asynchronous reading is active. Else the range is reduced when the monitored
+   * items are created again.
+   *
+   * If a chunk size is set in the map file the monitored range is split into several monitored items, such that the
+   * server only sends the chunks that changed. The chunks are assembled in lastValue and all chunks received in one
+   * iteration of the client are pushed to the accessors at once, so they end up in a single VersionNumber.
+   *
+   * If history registers are used a server queue is requested for the monitored item and all samples are collected in
+   * history. The history registers get the collected samples once per client iteration. The queue size is part of the
+   * item key, so other registers of the node do not share the item and still get one value per publishing interval.
+   *
+   * Channel groups use one monitored item per node, which are handled like chunks: the nodes are assembled in
+   * lastValue one after another and all nodes received in one iteration of the client are pushed at once.
+   *
+   * Aggregate registers use their own item, i.e. they do not share the monitored item with other registers of the node
+   * unless the same aggregate is requested. Only the reduced value is stored in lastValue and pushed to the accessors.
    */
   struct MonitorItem {
     UA_NodeId node;                                           ///< Node id of the process variable to be monitored
+    std::vector<UA_NodeId> channels; ///< Nodes of a channel group (borrowed from the catalogue), empty for other items
     std::vector<OpcUABackendRegisterAccessorBase*> accessors; ///< Pointer to the accessors using this item
-    UA_UInt32 id{0};          ///< ID of the monitored item that belongs to the subscription
-    bool active{false};       ///< If active the data is updated by the callback function
-    bool isMonitored{false};  ///< If true it is already added to the subscription as monitored item
+    std::vector<MonitorChunk> chunks; ///< Monitored items that belong to the subscription. Empty if not monitored.
+    bool active{false};               ///< If active the data is updated by the callback function
+    bool isMonitored{false};          ///< If true it is already added to the subscription as monitored item
     bool hasException{false}; ///< True if exception is thrown by a certain item and used to avoid sending exception
                               ///< twice in deactivateAllAndPushException
-    std::string browseName;   ///< browseName - used to compare monitored items -> \ToDo: use NodeStore?!
+    bool pending{false};      ///< True if chunks or samples were received that are not yet pushed to the accessors
+    bool initialized{false};  ///< True if the initial value was received since the monitored items were created.
+                              ///< Aggregates are always initialized, since they are only available after a window.
+    bool prefetched{false};   ///< True if lastValue was read by prefetchInitialValues() and no notification was
+                              ///< received since
+    std::string browseName;   ///< browseName of the register that created the item - only used for logging
+    std::string indexRange;   ///< Range monitored on the server. Empty if the whole node is monitored.
+    size_t rangeStart{0};     ///< First element of the node that is monitored
+    size_t rangeLength{0};    ///< Number of elements of the node that are monitored
+    size_t chunkSize{0};      ///< Number of elements per monitored item. 0 if the range is monitored by a single item.
+    size_t chunksReceived{0}; ///< Number of chunks received since the monitored items were created
+    size_t queueSize{1};      ///< Server queue size, i.e. the longest history requested by the accessors
+    ManagedDataValue lastValue; ///< Last value received. Used to set the initial value of accessors added later.
+    std::deque<ManagedDataValue> history; ///< Last queueSize samples received, the newest is the last one.
+    std::chrono::steady_clock::time_point pooledSince; ///< Time the last accessor was removed. Only used if pooled.
+    bool replaced{false}; ///< True if the item was replaced by another item. It is pooled until it is removed by the
+                          ///< client thread and not reused.
+    std::vector<OpcUABackendRegisterAccessorBase*> replacedAccessors; ///< Accessors taken over from the replaced item
+                                                                      ///< that did not receive a value of this one yet
+    UA_DateTime replacedSourceTime{0}; ///< Source time stamp of the last value of the replaced item
+    MonitorAggregate aggregate;           ///< Aggregate computed from the samples. Not used if aggregate type is none.
+
+    MonitorItem(const std::string& browseName, const UA_NodeId& node, OpcUABackendRegisterAccessorBase* accessor);
+    MonitorItem(const MonitorItem&) = delete;
+    MonitorItem& operator=(const MonitorItem&) = delete;
+
+    bool operator==(const UA_NodeId& other) const { return UA_NodeId_equal(&node, &other); }
 
-    MonitorItem(const std::string& browseName, const UA_NodeId& node, OpcUABackendRegisterAccessorBase* accessor)
-    : node(node), browseName(browseName) {
-      accessors.push_back(accessor);
-    };
-    friend bool operator==(const MonitorItem& lhs, const MonitorItem& rhs) { return lhs.browseName == rhs.browseName; }
-    bool operator==(const std::string& other) const { return browseName == other; }
+    /**
+     * True if the item monitors the given node with the aggregate settings, queue size and channels of the given
+     * register.
+     */
+    [[nodiscard]] bool matches(const UA_NodeId& other, const OpcUABackendRegisterInfo& info) const {
+      size_t infoQueueSize = info.historyContent != OpcUAHistoryContent::none ? info.arrayLength : 1;
+      return UA_NodeId_equal(&node, &other) && aggregate.settings.sameAggregate(info.options) &&
+          queueSize == infoQueueSize &&
+          std::equal(channels.begin(), channels.end(), info.channelIds.begin(), info.channelIds.end(),
+              [](const UA_NodeId& a, const UA_NodeId& b) { return UA_NodeId_equal(&a, &b); });
+    }
+
+    /**
+     * Node monitored by the monitored item of the given chunk.
+     */
+    [[nodiscard]] const UA_NodeId& getChunkNode(size_t chunk) const {
+      return channels.empty() ? node : channels.at(chunk);
+    }
+
+    [[nodiscard]] bool isAggregate() const { return aggregate.settings.aggregate != OpcUAAggregateType::none; }
+
+    /**
+     * True if the item has no accessors but is kept monitored, so it can be reused by accessors created later.
+     */
+    [[nodiscard]] bool isPooled() const { return accessors.empty(); }
+
+    /**
+     * True if the given accessor was taken over from a replaced item and already got a value with the given source
+     * time stamp from it, so the value is not pushed again.
+     */
+    [[nodiscard]] bool hasValue(const OpcUABackendRegisterAccessorBase* accessor, UA_DateTime sourceTime) const {
+      return sourceTime == replacedSourceTime &&
+          std::find(replacedAccessors.begin(), replacedAccessors.end(), accessor) != replacedAccessors.end();
+    }
+
+    /**
+     * Set indexRange, rangeStart and rangeLength to the minimal range covering the windows of all accessors and set the
+     * chunkSize to the smallest chunk size requested by the accessors and the queueSize to the longest history. It is
+     * called when accessors are added to or removed from an item that is not monitored and before the monitored items
+     * are created.
+     *
+     * \return True if the range, the chunk size or the queue size changed.
+     */
+    bool updateRange();
+
+    /**
+     * True if the given accessor can use the item without changing the monitored range. The chunk size requested by
+     * the accessor is not considered, it uses the chunks of the item.
+     */
+    [[nodiscard]] bool covers(const OpcUABackendRegisterAccessorBase* accessor) const;
+
+    /**
+     * Split the monitored range into chunks or one chunk per node of a channel group. Called before the monitored items
+     * are created.
+     */
+    void createChunks();
+
+    /**
+     * Get the IDs of all monitored items created for this item.
+     */
+    [[nodiscard]] std::vector<UA_UInt32> getMonitoredIds() const;
+
+    /**
+     * Copy the data of the given chunk into lastValue and mark the item as pending.
+     */
+    void updateChunk(size_t chunk, const UA_DataValue* value);
+
+    /**
+     * Append a copy of lastValue to the history and mark the item as pending.
+     */
+    void appendHistory();
+
+    /**
+     * Add a sample to the aggregate computed by the backend.
+     */
+    void addSample(const UA_DataValue* value);
+
+    /**
+     * True if the current window of the aggregate computed by the backend is complete, i.e. the number of samples or
+     * the time window given in the map file is reached.
+     */
+    [[nodiscard]] bool aggregateReady(const std::chrono::steady_clock::time_point& now) const;
+
+    /**
+     * Store the aggregate of the current window in lastValue and start a new window.
+     */
+    void finishAggregate();
+
+    /**
+     * Store the aggregate computed by the server in lastValue, converted to the data type of the aggregate register.
+     */
+    void setServerAggregate(const UA_DataValue* value);
+
+    /**
+     * Push the current data of this item to the given accessor, i.e. the window of lastValue or the history.
+     */
+    void push(OpcUABackendRegisterAccessorBase* accessor) const;
+
+    /**
+     * True if lastValue contains data of the whole monitored range.
+     */
+    [[nodiscard]] bool isComplete() const {
+      return chunks.size() > 1 ? chunksReceived == chunks.size() : lastValue.hasValue();
+    }
+
+    /**
+     * Get the data of the given accessor sliced out of the given value of this item.
+     */
+    ManagedDataValue getAccessorData(const UA_DataValue* value, const OpcUABackendRegisterAccessorBase* accessor) const;
   };
 
   /**
@@ -102,7 +288,13 @@ namespace ChimeraTK {
      */
     void subscribe(const std::string& browseName, const UA_NodeId& node, OpcUABackendRegisterAccessorBase* accessor);
 
-    void unsubscribe(const std::string& browseName, OpcUABackendRegisterAccessorBase* accessor);
+    /**
+     * Remove the accessor from the monitored item of the given node. If it was the last accessor the monitored item is
+     * removed, or kept in the pool for SubscriptionSettings::itemGracePeriod if the client thread is running. Else the
+     * monitored item is replaced by one monitoring the reduced range of the accessors left, if asynchronous reading is
+     * active and the range changes.
+     */
+    void unsubscribe(const UA_NodeId& node, OpcUABackendRegisterAccessorBase* accessor);
 
     /**
      * Start the thread that updates data of accessors.
@@ -125,10 +317,27 @@ namespace ChimeraTK {
 
     bool isRunning() { return _run; }
 
+    /**
+     * Wait until the initial values of all active monitored items are received, either read by
+     * prefetchInitialValues() or sent with the first publish response. The wait is bounded by two publishing intervals
+     * plus the connection timeout.
+     *
+     * \remark Holds item lock.
+     * \return False if not all initial values were received in time.
+     */
+    bool waitForInitialValues();
+
     [[nodiscard]] bool isAsyncReadActive() const { return _asyncReadActive; };
 
+    /**
+     * Get the number of OPC UA monitored items of the subscription.
+     *
+     * \remark Holds item lock.
+     */
+    size_t getNumberOfMonitoredItems();
+
     // Report an exception to the subscription manager. E.g. thrown by the RegisterAccessor.
-    void setExternalError(const std::string& browseName);
+    void setExternalError(const UA_NodeId& node);
 
     std::mutex mutex; ///< Mutex used to protect writing non atomic member variables of items in the _items vector (can
                       ///< not use atomic because we put it into a vector of unknown size)
@@ -174,6 +383,134 @@ namespace ChimeraTK {
      */
     void addMonitoredItems();
 
+    /**
+     * Read the initial values of all active monitored items that did not receive a value yet with a single read
+     * request and push them to the accessors. So the accessors get their initial values without waiting for the first
+     * publish response. The first notification is not pushed again if it has the same source time stamp.
+     * Chunked items and aggregates are not read.
+     *
+     * \remark It holds the client lock and item lock, but not at the same time.
+     */
+    void prefetchInitialValues();
+
+    /**
+     * Read the samples missed during a connection loss from the server history (HistoryReadRaw) and push them to the
+     * accessors in time stamp order. Used for items of registers with a backfill length set in the map file, that
+     * received data before, i.e. the outage window starts at the source time stamp of lastValue. Each item is read
+     * from its own outage window with its own backfill length. Items sharing both are read with a single request. It
+     * is called in activate() before the current values are pushed.
+     *
+     * \remark It holds the client lock and item lock, but not at the same time. Only available if open62541 is built
+     * with UA_ENABLE_HISTORIZING.
+     */
+    void backfillHistory();
+
+    /**
+     * Item to be read from the server history by backfillHistory().
+     */
+    struct BackfillNode {
+      MonitorItem* item;
+      UA_DateTime lastTime; ///< Source time stamp of the last value known by the accessors
+      UA_UInt32 length;     ///< Maximum number of samples to be delivered
+      UA_HistoryReadValueId id; ///< Owns node id, index range and the continuation point returned by the server
+    };
+
+#ifdef UA_ENABLE_HISTORIZING
+    /**
+     * Read the history of the given nodes with a single request starting after the lastTime of the first node with
+     * its length and push the samples to the items. Continuation points returned by the server are released, since
+     * samples beyond the length are not delivered.
+     *
+     * \remark Nodes must share lastTime and length. It holds the client lock and item lock, but not at the same time.
+     * \return The number of samples delivered.
+     */
+    size_t readHistory(BackfillNode* nodes, size_t nNodes);
+#endif
+
+    /**
+     * Store the given value of an item that is not chunked in lastValue and push it to the accessors. Samples for
+     * history accessors are collected and pushed in pushPendingItems().
+     *
+     * \remark Item lock needs to be held. The content of value is taken over.
+     */
+    void updateItem(MonitorItem& item, UA_DataValue* value);
+
+    /// Notified when items received their initial value.
+    std::condition_variable _initialValueCondition;
+
+    /**
+     * Create the monitored items of the given item.
+     *
+     * \remark Item lock needs to be held. It is released while talking to the server and the client lock is held.
+     * \return The status of the creation. If it is not good no monitored item is left on the server.
+     */
+    UA_StatusCode createMonitoredItems(MonitorItem& item);
+
+    /**
+     * Set the parameters of a monitored item used for an aggregate. If the aggregate is computed by the server an
+     * AggregateFilter is added, else all samples are requested.
+     */
+    void setAggregateParameters(const MonitorItem& item, UA_MonitoredItemCreateRequest& request) const;
+
+    /**
+     * Replace the given monitored item by a new item used by the given accessors, e.g. to monitor a wider range. The
+     * accessors of the old item keep their values, i.e. the initial value of the new item is only pushed to them if its
+     * source time stamp differs from the last value of the old item. The old item is pooled without accessors until
+     * the client thread removes it in releasePooledItems(). If the client thread is not running, the old item is
+     * removed from the items right away and the IDs of its monitored items are added to ids. If the new item would
+     * monitor the same range as the old one, the old item is kept for the given accessors instead.
+     *
+     * \remark Item lock needs to be held. The caller has to create the monitored items of the new item.
+     * \return The new item or the old one, if it was kept.
+     */
+    MonitorItem& replaceItem(std::list<MonitorItem>::iterator old,
+        const std::vector<OpcUABackendRegisterAccessorBase*>& accessors, std::vector<UA_UInt32>& ids);
+
+    /**
+     * Remove the monitored items with the given ids from the subscription.
+     *
+     * \remark This method holds the client lock.
+     */
+    void removeMonitoredItems(const std::vector<UA_UInt32>& ids, const std::string& browseName);
+
+    /**
+     * Remove the monitored items of the given item from the subscriptionMap and mark it as not monitored.
+     *
+     * \remark Item lock needs to be held.
+     * \return The IDs of the monitored items to be removed from the subscription.
+     */
+    std::vector<UA_UInt32> releaseMonitoredItems(MonitorItem& item);
+
+    /**
+     * Push the assembled data of all items that received chunks, the history of all items that received samples and
+     * completed aggregate windows to the accessors. It is called after each iteration of the client, so that all data
+     * received in the same publish response is pushed together.
+     *
+     * \remark Holds item lock.
+     */
+    void pushPendingItems();
+
+    /**
+     * Remove pooled items from the subscription whose grace period expired and the oldest ones exceeding
+     * SubscriptionSettings::maxPooledItems. All monitored items are deleted with a single request. It is called after
+     * each iteration of the client, so accessors are not blocked by the removal.
+     *
+     * \remark It holds the client lock and item lock, but not at the same time.
+     */
+    void releasePooledItems();
+
+    /// True if items are kept in the pool, which are checked in releasePooledItems().
+    std::atomic<bool> _hasPooledItems{false};
+
+    /// True if chunks or history samples were received that were not pushed to the accessors yet.
+    std::atomic<bool> _itemsPending{false};
+
+    /// True if aggregates are computed by the backend, which are checked for complete windows in pushPendingItems().
+    std::atomic<bool> _clientAggregates{false};
+
+    /// Server queue size used for aggregates computed by the backend.
+    static constexpr UA_UInt32 aggregateQueueSize{1000};
+
     /**
      * Set up the subscription.
      * It is called by setClient().
@@ -182,6 +519,42 @@ namespace ChimeraTK {
      */
     void createSubscription();
 
+    /**
+     * Derive the subscription parameters not set by the user in OPCUAConnection::subscriptionSettings.
+     *
+     * - publishRequests: enough publish requests to cover one round trip, i.e. the server always holds a request to
+     *   answer when the publishing interval elapses (at least 2)
+     * - maxNotificationsPerPublish: twice the given number of notifications of one update of all monitored items (at
+     *   least minNotificationsPerPublish), so a single publish response can carry one update of every item plus backlog
+     * - maxKeepAliveCount: keep alive interval covers at least 3 round trips (at least the OPC UA default of 10)
+     * - lifetimeCount: at least 3 times the keep alive count as required by OPC UA (at least the default of 10000)
+     */
+    [[nodiscard]] SubscriptionSettings deriveSettings(size_t nNotifications) const;
+
+    /**
+     * Number of notifications of one update of all monitored items, i.e. the queued samples of all chunks.
+     *
+     * \remark This method takes the item mutex, so it must not be held when calling it.
+     */
+    size_t countNotifications();
+
+    /**
+     * Apply the derived subscription settings to the subscription if they changed, e.g. because monitored items were
+     * added.
+     *
+     * \remark This method holds the client lock.
+     */
+    void updateSubscriptionSettings();
+
+    /// Settings used for the current subscription.
+    SubscriptionSettings _activeSettings{};
+
+    /// Lower limit for the derived maxNotificationsPerPublish.
+    static constexpr UA_UInt32 minNotificationsPerPublish{100};
+
+    /// Upper limit for the derived number of outstanding publish requests.
+    static constexpr UA_UInt16 maxPublishRequests{32};
+
     std::atomic<bool> _run{false};
     std::atomic<bool> _subscriptionActive{false};
     std::atomic<bool> _subscriptionNeedsToBeRemoved{false};
@@ -191,17 +564,17 @@ namespace ChimeraTK {
 
     UA_UInt32 _subscriptionID{0};
 
-    // List of items to be monitored
-    std::deque<MonitorItem> _items;
+    // List of items to be monitored - a list is used because subscriptionMap keeps pointers to the items
+    std::list<MonitorItem> _items;
 
     /*
-     *  map that links a monitoredItemId to the corresponding MonitoredItem in _items.
+     *  map that links a monitoredItemId to the corresponding MonitoredItem in _items and the index of the chunk.
      *  This is needed because when adding MonitorItems to _items the monitoredItemIds are not known.
      *  Only after activate is called the monitoredItemIds are known. A map is used to allow fast
      *  access in the responseHandler. Else one would have to search in _items for the item with the correct
      *  monitoredItemId.
      */
-    std::map<UA_UInt32, MonitorItem*> subscriptionMap;
+    std::map<UA_UInt32, std::pair<MonitorItem*, size_t>> subscriptionMap;
 
     /*
      *  Send exception to all accessors via the future queue.
@@ -0,0 +1,228 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * AsyncWriter.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "AsyncWriter.h"
+
+#include "OPC-UA-Backend.h"
+
+#include <ChimeraTK/Exception.h>
+
+#include <open62541/client.h>
+#include <open62541/client_highlevel_async.h>
+#include <open62541/plugin/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+namespace ChimeraTK {
+
+  OPCUAAsyncWriter::OPCUAAsyncWriter(std::shared_ptr<OPCUAConnection> connection, size_t maxPending,
+      std::function<void(const std::string&)> onFailure)
+  : _connection(std::move(connection)), _maxPending(std::max<size_t>(maxPending, 1)),
+    _onFailure(std::move(onFailure)) {}
+
+  OPCUAAsyncWriter::~OPCUAAsyncWriter() {
+    stop();
+  }
+
+  void OPCUAAsyncWriter::write(
+      const UA_NodeId& node, const UA_Variant& value, const std::string& browseName, const std::string& indexRange) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto canQueue = [&] { return !_error.empty() || !_run || _pending.size() < _maxPending; };
+    if(!_condition.wait_for(lock, std::chrono::milliseconds(_connection->connectionTimeout), canQueue)) {
+      throw ChimeraTK::runtime_error(std::string("OPC-UA-Backend::Failed to write variable: ") + browseName +
+          " with reason: Timeout waiting for " + std::to_string(_pending.size()) + " pending writes.");
+    }
+    if(!_error.empty()) {
+      throw ChimeraTK::runtime_error(_error);
+    }
+    auto& entry = _pending.emplace_back();
+    UA_NodeId_copy(&node, &entry.node);
+    UA_Variant_copy(&value, &entry.value);
+    entry.indexRange = indexRange;
+    entry.browseName = browseName;
+    _condition.notify_all();
+  }
+
+  void OPCUAAsyncWriter::waitUntilWritten(const UA_NodeId& node) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait_for(lock, std::chrono::milliseconds(_connection->connectionTimeout), [&] {
+      return !_run || std::none_of(_pending.begin(), _pending.end(),
+                          [&](const PendingWrite& entry) { return UA_NodeId_equal(&entry.node, &node); });
+    });
+  }
+
+  void OPCUAAsyncWriter::start() {
+    // writes of a previous session are sent or dropped before starting again
+    stop();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      clear();
+      _error.clear();
+      _errorReported = false;
+      _run = true;
+    }
+    _thread = std::make_unique<std::thread>(&OPCUAAsyncWriter::run, this);
+  }
+
+  void OPCUAAsyncWriter::stop() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _run = false;
+    }
+    _condition.notify_all();
+    if(_thread && _thread->joinable()) {
+      _thread->join();
+    }
+    _thread.reset();
+    // send the queued writes and wait for the responses
+    std::lock_guard<std::mutex> clientLock(_connection->client_lock);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(_connection->connectionTimeout);
+    while(_connection->isConnected() && std::chrono::steady_clock::now() < deadline) {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_pending.empty()) {
+          return;
+        }
+      }
+      sendPending();
+      UA_Client_run_iterate(_connection->client.get(), 10);
+    }
+    bool inFlight;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if(_pending.empty()) {
+        return;
+      }
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Dropping %zu writes that were not confirmed by the server.", _pending.size());
+      inFlight = _inFlight > 0;
+    }
+    if(inFlight) {
+      // the callbacks of writes in flight refer to this object - closing the session aborts them
+      _connection->close();
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    clear();
+  }
+
+  void OPCUAAsyncWriter::sendPending() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    // only the oldest write of a node is sent, so writes of the same node are not reordered
+    std::unordered_set<UA_NodeId, NodeIdHash, NodeIdEqual> blocked;
+    for(auto it = _pending.begin(); it != _pending.end();) {
+      if(!blocked.insert(it->node).second || it->requestId != 0) {
+        ++it;
+        continue;
+      }
+      UA_WriteValue writeValue;
+      UA_WriteValue_init(&writeValue);
+      writeValue.nodeId = _connection->resolve(it->node);
+      writeValue.attributeId = UA_ATTRIBUTEID_VALUE;
+      writeValue.indexRange = UA_STRING(it->indexRange.data());
+      writeValue.value.hasValue = true;
+      writeValue.value.value = it->value;
+      UA_WriteRequest request;
+      UA_WriteRequest_init(&request);
+      request.nodesToWrite = &writeValue;
+      request.nodesToWriteSize = 1;
+      // the request is encoded when sending, so node and value are only borrowed
+      UA_StatusCode status = UA_Client_sendAsyncWriteRequest(
+          _connection->client.get(), &request, &OPCUAAsyncWriter::writeCallback, this, &it->requestId);
+      if(status == UA_STATUSCODE_GOOD) {
+        ++_inFlight;
+        ++it;
+        continue;
+      }
+      std::string message = std::string("OPC-UA-Backend::Failed to write variable: ") + it->browseName +
+          " with reason: " + UA_StatusCode_name(status);
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "%s", message.c_str());
+      if(_run && _error.empty()) {
+        _error = message;
+      }
+      // the set only borrows the node id
+      blocked.erase(it->node);
+      UA_NodeId_clear(&it->node);
+      UA_Variant_clear(&it->value);
+      it = _pending.erase(it);
+    }
+    _condition.notify_all();
+  }
+
+  void OPCUAAsyncWriter::writeCallback(
+      UA_Client* /*client*/, void* userdata, UA_UInt32 requestId, UA_WriteResponse* response) {
+    UA_StatusCode status = response->responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD) {
+      status = response->resultsSize == 1 ? response->results[0] : UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    static_cast<OPCUAAsyncWriter*>(userdata)->complete(requestId, status);
+  }
+
+  void OPCUAAsyncWriter::complete(UA_UInt32 requestId, UA_StatusCode status) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = std::find_if(
+        _pending.begin(), _pending.end(), [&](const PendingWrite& entry) { return entry.requestId == requestId; });
+    if(it == _pending.end()) {
+      return;
+    }
+    if(status != UA_STATUSCODE_GOOD) {
+      std::string message = std::string("OPC-UA-Backend::Failed to write variable: ") + it->browseName +
+          " with reason: " + UA_StatusCode_name(status);
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "%s", message.c_str());
+      // failures when closing the device are not reported
+      if(_run && _error.empty()) {
+        _error = message;
+      }
+    }
+    UA_NodeId_clear(&it->node);
+    UA_Variant_clear(&it->value);
+    _pending.erase(it);
+    --_inFlight;
+    _condition.notify_all();
+  }
+
+  void OPCUAAsyncWriter::clear() {
+    for(auto& entry : _pending) {
+      UA_NodeId_clear(&entry.node);
+      UA_Variant_clear(&entry.value);
+    }
+    _pending.clear();
+    _inFlight = 0;
+  }
+
+  void OPCUAAsyncWriter::run() {
+    while(_run) {
+      {
+        std::lock_guard<std::mutex> clientLock(_connection->client_lock);
+        sendPending();
+        // the responses might also be processed by the client thread of the subscription manager
+        UA_Client_run_iterate(_connection->client.get(), 0);
+      }
+      std::string error;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if(!_error.empty() && !_errorReported) {
+          _errorReported = true;
+          error = _error;
+        }
+        else if(_pending.empty()) {
+          _condition.wait(lock, [this] { return !_run || !_pending.empty(); });
+        }
+        else {
+          // responses are polled, since the client has no way to wake up this thread
+          _condition.wait_for(lock, std::chrono::milliseconds(1), [this] { return !_run; });
+        }
+      }
+      if(!error.empty()) {
+        // the backend is informed without holding a lock, since setting the exception stops other client users
+        _onFailure(error);
+      }
+    }
+  }
+} // namespace ChimeraTK
@@ -124,13 +124,18 @@ namespace ChimeraTK::Cache {
 
   void parseRegister(
       xmlpp::Element const* registerNode, OpcUaBackendRegisterCatalogue& catalogue, const std::string& serverAddress) {
-    std::string nodeId, name, description, indexRange;
+    std::string nodeId, name, description, indexRange, structureType;
     bool isReadonly, isNumeric;
     uint32_t typeId;
     uint16_t namespaceId;
     unsigned int length{};
+    size_t channels{0};
+    size_t structureField{0};
     ChimeraTK::DataDescriptor descriptor{};
     ChimeraTK::AccessModeFlags flags{};
+    OpcUABackendRegisterOptions options{};
+    OpcUAHistoryContent history{OpcUAHistoryContent::none};
+    std::vector<UA_NodeId> channelNodes;
 
     for(const auto& node : registerNode->get_children()) {
       const auto* e = dynamic_cast<const xmlpp::Element*>(node);
@@ -148,6 +153,9 @@ namespace ChimeraTK::Cache {
       else if(nodeName == "length") {
         length = parseLength(e);
       }
+      else if(nodeName == "channels") {
+        channels = parseLength(e);
+      }
       else if(nodeName == "access_mode") {
         flags = parseAccessMode(e);
       }
@@ -173,14 +181,114 @@ namespace ChimeraTK::Cache {
           indexRange = e->get_child_text()->get_content();
         }
       }
+      else if(nodeName == "structureType") {
+        structureType = e->get_child_text()->get_content();
+      }
+      else if(nodeName == "structureField") {
+        structureField = parseLength(e);
+      }
+      else if(nodeName == "channelNode") {
+        UA_NodeId channel;
+        std::string content = e->get_child_text()->get_content();
+        if(UA_NodeId_parse(&channel, UA_STRING(const_cast<char*>(content.c_str()))) != UA_STATUSCODE_GOOD) {
+          for(auto& channelNode : channelNodes) {
+            UA_NodeId_clear(&channelNode);
+          }
+          throw ChimeraTK::logic_error("Invalid channel node '" + content + "' in line " +
+              std::to_string(e->get_line()) + " of the cache file.");
+        }
+        channelNodes.push_back(channel);
+      }
+      else if(nodeName == "chunkSize") {
+        options.chunkSize = parseLength(e);
+      }
+      else if(nodeName == "aggregate" || nodeName == "aggregateInterval") {
+        try {
+          if(nodeName == "aggregate") {
+            options.aggregate = aggregateFromString(e->get_child_text()->get_content());
+          }
+          else {
+            options.aggregateInterval = std::stod(e->get_child_text()->get_content());
+          }
+        }
+        catch(std::logic_error& ex) {
+          throw ChimeraTK::logic_error(
+              std::string(ex.what()) + " in line " + std::to_string(e->get_line()) + " of the cache file.");
+        }
+      }
+      else if(nodeName == "aggregateSamples") {
+        options.aggregateSamples = parseLength(e);
+      }
+      else if(nodeName == "publisherId") {
+        options.publisherId = parseTypeId(e);
+      }
+      else if(nodeName == "writerGroupId") {
+        options.writerGroupId = parseTypeId(e);
+      }
+      else if(nodeName == "dataSetWriterId") {
+        options.dataSetWriterId = parseTypeId(e);
+      }
+      else if(nodeName == "dataSetField") {
+        options.dataSetField = parseLength(e);
+      }
+      else if(nodeName == "backfill") {
+        options.backfillLength = parseLength(e);
+      }
+      else if(nodeName == "pollInterval") {
+        options.pollInterval = parseLength(e);
+      }
+      else if(nodeName == "maxAge") {
+        try {
+          options.maxAge = std::stod(e->get_child_text()->get_content());
+        }
+        catch(std::logic_error& ex) {
+          throw ChimeraTK::logic_error(
+              std::string(ex.what()) + " in line " + std::to_string(e->get_line()) + " of the cache file.");
+        }
+      }
+      else if(nodeName == "priority") {
+        std::string content = e->get_child_text()->get_content();
+        if(content != "high" && content != "normal") {
+          throw ChimeraTK::logic_error("Unknown priority '" + content + "' in line " + std::to_string(e->get_line()) +
+              " of the cache file.");
+        }
+        options.highPriority = content == "high";
+      }
+      else if(nodeName == "history") {
+        std::string content = e->get_child_text()->get_content();
+        if(content == "values") {
+          history = OpcUAHistoryContent::values;
+        }
+        else if(content == "timestamps") {
+          history = OpcUAHistoryContent::timestamps;
+        }
+        else {
+          throw ChimeraTK::logic_error("Unknown history content '" + content + "' in line " +
+              std::to_string(e->get_line()) + " of the cache file.");
+        }
+      }
+    }
+    if(!channelNodes.empty()) {
+      catalogue.addChannelGroup(
+          channelNodes, name, typeId, length, serverAddress, description, isReadonly, options);
+      for(auto& channelNode : channelNodes) {
+        UA_NodeId_clear(&channelNode);
+      }
+    }
+    else if(!structureType.empty()) {
+      // the decoder of the structure is created by the backend after connecting
+      UA_NodeId node = isNumeric ? UA_NODEID_NUMERIC(namespaceId, std::stoul(nodeId)) :
+                                   UA_NODEID_STRING(namespaceId, const_cast<char*>(nodeId.c_str()));
+      catalogue.addStructureField(
+          node, name, typeId, serverAddress, description, options, structureType, structureField, nullptr);
     }
-    if(isNumeric) {
+    else if(isNumeric) {
       catalogue.addProperty(UA_NODEID_NUMERIC(namespaceId, std::stoul(nodeId)), name, indexRange, typeId, length,
-          serverAddress, description, isReadonly);
+          serverAddress, description, isReadonly, options, history, channels);
     }
     else {
       catalogue.addProperty(UA_NODEID_STRING(namespaceId, const_cast<char*>(nodeId.c_str())), name, indexRange, typeId,
-          length, serverAddress, description, isReadonly);
+          length, serverAddress, description, isReadonly, options, history, channels);
     }
   }
 
@@ -208,6 +316,11 @@ namespace ChimeraTK::Cache {
     auto* lengthTag = registerTag->add_child("length");
     lengthTag->set_child_text(std::to_string(r.getNumberOfElements()));
 
+    if(r.isMultiDimensional) {
+      auto* channelsTag = registerTag->add_child("channels");
+      channelsTag->set_child_text(std::to_string(r.getNumberOfChannels()));
+    }
+
     auto* accessMode = registerTag->add_child("access_mode");
     accessMode->set_child_text(r.accessModes.serialize());
 
@@ -225,5 +338,70 @@ namespace ChimeraTK::Cache {
 
     auto* indexRangeTag = registerTag->add_child("indexRange");
     indexRangeTag->set_child_text(static_cast<std::string>(r.indexRange));
+
+    if(r.isStructureField()) {
+      auto* structureTypeTag = registerTag->add_child("structureType");
+      structureTypeTag->set_child_text(r.structureType);
+      auto* structureFieldTag = registerTag->add_child("structureField");
+      structureFieldTag->set_child_text(std::to_string(r.structureField));
+    }
+
+    for(const auto& channel : r.channelIds) {
+      UA_String channelName = UA_STRING_NULL;
+      UA_NodeId_print(&channel, &channelName);
+      auto* channelTag = registerTag->add_child("channelNode");
+      channelTag->set_child_text(std::string((char*)channelName.data, channelName.length));
+      UA_String_clear(&channelName);
+    }
+
+    if(r.options.chunkSize != 0) {
+      auto* chunkSizeTag = registerTag->add_child("chunkSize");
+      chunkSizeTag->set_child_text(std::to_string(r.options.chunkSize));
+    }
+
+    if(r.options.aggregate != OpcUAAggregateType::none) {
+      auto* aggregateTag = registerTag->add_child("aggregate");
+      aggregateTag->set_child_text(toString(r.options.aggregate));
+      auto* intervalTag = registerTag->add_child("aggregateInterval");
+      intervalTag->set_child_text(std::to_string(r.options.aggregateInterval));
+      auto* samplesTag = registerTag->add_child("aggregateSamples");
+      samplesTag->set_child_text(std::to_string(r.options.aggregateSamples));
+    }
+
+    if(r.options.usesPubSub()) {
+      auto* publisherIdTag = registerTag->add_child("publisherId");
+      publisherIdTag->set_child_text(std::to_string(r.options.publisherId));
+      auto* writerGroupIdTag = registerTag->add_child("writerGroupId");
+      writerGroupIdTag->set_child_text(std::to_string(r.options.writerGroupId));
+      auto* dataSetWriterIdTag = registerTag->add_child("dataSetWriterId");
+      dataSetWriterIdTag->set_child_text(std::to_string(r.options.dataSetWriterId));
+      auto* dataSetFieldTag = registerTag->add_child("dataSetField");
+      dataSetFieldTag->set_child_text(std::to_string(r.options.dataSetField));
+    }
+
+    if(r.options.backfillLength != 0) {
+      auto* backfillTag = registerTag->add_child("backfill");
+      backfillTag->set_child_text(std::to_string(r.options.backfillLength));
+    }
+
+    if(r.options.usesPolling()) {
+      auto* pollIntervalTag = registerTag->add_child("pollInterval");
+      pollIntervalTag->set_child_text(std::to_string(r.options.pollInterval));
+    }
+
+    if(r.options.maxAge >= 0) {
+      auto* maxAgeTag = registerTag->add_child("maxAge");
+      maxAgeTag->set_child_text(std::to_string(r.options.maxAge));
+    }
+
+    if(r.options.highPriority) {
+      auto* priorityTag = registerTag->add_child("priority");
+      priorityTag->set_child_text("high");
+    }
+
+    if(r.historyContent != OpcUAHistoryContent::none) {
+      auto* historyTag = registerTag->add_child("history");
+      historyTag->set_child_text(r.historyContent == OpcUAHistoryContent::values ? "values" : "timestamps");
+    }
   }
 } // namespace ChimeraTK::Cache
@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * HealthMonitor.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "HealthMonitor.h"
+
+#include "OPC-UA-Backend.h"
+
+#include <open62541/client.h>
+#include <open62541/plugin/log.h>
+
+#include <chrono>
+#include <sstream>
+
+namespace ChimeraTK {
+
+  OPCUAHealthMonitor::OPCUAHealthMonitor(std::shared_ptr<OPCUAConnection> connection,
+      const HealthMonitorSettings& settings, std::function<void(const std::string&)> onFailure)
+  : _connection(std::move(connection)), _settings(settings), _onFailure(std::move(onFailure)) {}
+
+  OPCUAHealthMonitor::~OPCUAHealthMonitor() {
+    stop();
+  }
+
+  void OPCUAHealthMonitor::start() {
+    if(_thread) {
+      return;
+    }
+    UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+        "Starting health monitor with probe interval of %ums.", _settings.interval);
+    _run = true;
+    _thread = std::make_unique<std::thread>(&OPCUAHealthMonitor::run, this);
+  }
+
+  void OPCUAHealthMonitor::stop() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _run = false;
+    }
+    _stopCondition.notify_all();
+    if(_thread && _thread->joinable()) {
+      _thread->join();
+    }
+    _thread.reset();
+  }
+
+  void OPCUAHealthMonitor::run() {
+    while(_run) {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stopCondition.wait_for(lock, std::chrono::milliseconds(_settings.interval), [this] { return !_run; });
+      }
+      if(!_run) {
+        break;
+      }
+      if(!_connection->isConnected()) {
+        // the start time is read again once the connection is established
+        _startTime = 0;
+        _failed = false;
+        _slow = false;
+        continue;
+      }
+      if(_failed) {
+        continue;
+      }
+      auto message = probe();
+      if(!message.empty()) {
+        _failed = true;
+        UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Health monitor: %s", message.c_str());
+        _onFailure(message);
+      }
+    }
+  }
+
+  std::string OPCUAHealthMonitor::probe() {
+    UA_ReadValueId ids[2];
+    UA_ReadValueId_init(&ids[0]);
+    ids[0].nodeId = UA_NS0ID(SERVER_SERVERSTATUS_STATE);
+    ids[0].attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_ReadValueId_init(&ids[1]);
+    ids[1].nodeId = UA_NS0ID(SERVER_SERVERSTATUS_STARTTIME);
+    ids[1].attributeId = UA_ATTRIBUTEID_VALUE;
+
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = ids;
+    request.nodesToReadSize = 2;
+
+    UA_ReadResponse response;
+    double roundTripTime;
+    {
+      std::lock_guard<std::mutex> lock(_connection->client_lock);
+      auto start = std::chrono::steady_clock::now();
+      response = UA_Client_Service_read(_connection->client.get(), request);
+      roundTripTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if(response.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+        _connection->roundTripTime = roundTripTime;
+      }
+    }
+
+    std::stringstream message;
+    UA_StatusCode status = response.responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD && response.resultsSize != 2) {
+      status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    if(status == UA_STATUSCODE_BADSESSIONIDINVALID || status == UA_STATUSCODE_BADSESSIONCLOSED ||
+        status == UA_STATUSCODE_BADSESSIONNOTACTIVATED) {
+      message << "Session is not known by the server any more. The server restarted. (" << UA_StatusCode_name(status)
+              << ")";
+    }
+    else if(status != UA_STATUSCODE_GOOD) {
+      message << "Link to the server dropped. (" << UA_StatusCode_name(status) << ")";
+    }
+    else {
+      const UA_DataValue& state = response.results[0];
+      const UA_DataValue& startTime = response.results[1];
+      if(state.hasValue && UA_Variant_hasScalarType(&state.value, &UA_TYPES[UA_TYPES_SERVERSTATE]) &&
+          *static_cast<UA_ServerState*>(state.value.data) != UA_SERVERSTATE_RUNNING) {
+        message << "Server is not running any more (server state " << *static_cast<UA_ServerState*>(state.value.data)
+                << "). The server is shutting down or restarting.";
+      }
+      else if(startTime.hasValue && UA_Variant_hasScalarType(&startTime.value, &UA_TYPES[UA_TYPES_DATETIME])) {
+        auto currentStartTime = *static_cast<UA_DateTime*>(startTime.value.data);
+        if(_startTime == 0) {
+          _startTime = currentStartTime;
+        }
+        else if(_startTime != currentStartTime) {
+          message << "Server start time changed. The server restarted.";
+          _startTime = currentStartTime;
+        }
+      }
+      if(_settings.maxRoundTripTime > 0) {
+        bool slow = roundTripTime > _settings.maxRoundTripTime;
+        if(slow && !_slow) {
+          UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "Health monitor: Round trip time of %fms exceeds %fms.", roundTripTime, _settings.maxRoundTripTime);
+        }
+        _slow = slow;
+      }
+    }
+    UA_ReadResponse_clear(&response);
+    return message.str();
+  }
+} // namespace ChimeraTK
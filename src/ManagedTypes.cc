@@ -11,6 +11,8 @@
 
 #include <open62541/types.h>
 
+#include <cstring>
+
 namespace ChimeraTK {
   ManagedVariant::ManagedVariant() {
     var = UA_Variant_new();
@@ -23,11 +25,44 @@ namespace ChimeraTK {
     UA_DataValue_init(&_val);
   }
 
-  ManagedDataValue::ManagedDataValue(UA_DataValue* data) {
+  ManagedDataValue::ManagedDataValue(const UA_DataValue* data) {
     UA_DataValue_init(&_val);
     UA_DataValue_copy(data, &_val);
   }
 
+  ManagedDataValue::ManagedDataValue(const UA_DataValue* data, size_t offset, size_t length) {
+    // all members except the variant are plain values
+    _val = *data;
+    UA_Variant_init(&_val.value);
+    if(!data->hasValue) {
+      return;
+    }
+    UA_NumericRangeDimension dimension{(UA_UInt32)offset, (UA_UInt32)(offset + length - 1)};
+    UA_NumericRange range{1, &dimension};
+    UA_StatusCode ret = UA_Variant_copyRange(&data->value, &_val.value, range);
+    if(ret != UA_STATUSCODE_GOOD) {
+      _val.hasValue = false;
+      _val.hasStatus = true;
+      _val.status = ret;
+    }
+  }
+
+  ManagedDataValue::ManagedDataValue(const UA_DataValue* data, const std::string& range) {
+    _val = *data;
+    UA_Variant_init(&_val.value);
+    if(!data->hasValue) {
+      return;
+    }
+    UA_NumericRange numericRange = UA_NUMERICRANGE(range.c_str());
+    UA_StatusCode ret = UA_Variant_copyRange(&data->value, &_val.value, numericRange);
+    UA_free(numericRange.dimensions);
+    if(ret != UA_STATUSCODE_GOOD) {
+      _val.hasValue = false;
+      _val.hasStatus = true;
+      _val.status = ret;
+    }
+  }
+
   ManagedDataValue::ManagedDataValue(const ManagedDataValue& other) {
     UA_DataValue_init(&_val);
     _val.status = UA_DataValue_copy(&other._val, &_val);
@@ -95,6 +130,16 @@ namespace ChimeraTK {
   }
 
   void ManagedDataValue::copyVariant(const UA_Variant& src, const std::string& dataRange) {
+    if(dataRange.empty() && reuseVariant(src)) {
+      // drop time stamps and status of the previous value like prepare() does
+      UA_Variant value = _val.value;
+      UA_DataValue_init(&_val);
+      _val.value = value;
+      _val.hasValue = true;
+      _val.sourceTimestamp = UA_DateTime_now();
+      _val.hasSourceTimestamp = true;
+      return;
+    }
     prepare();
     UA_StatusCode ret;
     if(dataRange.empty()) {
@@ -114,6 +159,91 @@ namespace ChimeraTK {
     _clearData = true;
   }
 
+  void ManagedDataValue::moveFrom(UA_DataValue* data) {
+    prepare();
+    _val = *data;
+    UA_DataValue_init(data);
+    _clearData = true;
+  }
+
+  UA_StatusCode ManagedDataValue::setRange(const UA_DataValue* data, size_t offset, size_t length) {
+    // scalars (e.g. nodes of a channel group) are copied like arrays of one element
+    size_t count = UA_Variant_isScalar(&data->value) ? 1 : data->value.arrayLength;
+    if(!data->hasValue || offset + count > length) {
+      return UA_STATUSCODE_BADINDEXRANGEINVALID;
+    }
+    const UA_DataType* type = data->value.type;
+    if(!hasValue() || _val.value.type != type || _val.value.arrayLength != length) {
+      prepare();
+      UA_DataValue_init(&_val);
+      void* array = UA_Array_new(length, type);
+      if(array == nullptr) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+      }
+      UA_Variant_setArray(&_val.value, array, length, type);
+      _val.hasValue = true;
+      _clearData = true;
+    }
+    if(count == 0) {
+      return UA_STATUSCODE_GOOD;
+    }
+    UA_NumericRangeDimension dimension{(UA_UInt32)offset, (UA_UInt32)(offset + count - 1)};
+    UA_NumericRange range{1, &dimension};
+    UA_StatusCode ret = UA_Variant_setRangeCopy(&_val.value, data->value.data, count, range);
+    if(ret != UA_STATUSCODE_GOOD) {
+      return ret;
+    }
+    if(data->hasSourceTimestamp && (!_val.hasSourceTimestamp || data->sourceTimestamp > _val.sourceTimestamp)) {
+      _val.hasSourceTimestamp = true;
+      _val.sourceTimestamp = data->sourceTimestamp;
+    }
+    if(data->hasServerTimestamp && (!_val.hasServerTimestamp || data->serverTimestamp > _val.serverTimestamp)) {
+      _val.hasServerTimestamp = true;
+      _val.serverTimestamp = data->serverTimestamp;
+    }
+    return UA_STATUSCODE_GOOD;
+  }
+
+  UA_StatusCode ManagedDataValue::allocate(const UA_DataType* type, size_t length, bool scalar) {
+    const UA_Variant& value = _val.value;
+    if(hasValue() && _clearData && value.type == type && value.storageType == UA_VARIANT_DATA &&
+        value.arrayDimensionsSize == 0 && UA_Variant_isScalar(&value) == scalar &&
+        (scalar || value.arrayLength == length)) {
+      return UA_STATUSCODE_GOOD;
+    }
+    prepare();
+    UA_DataValue_init(&_val);
+    void* data = scalar ? UA_new(type) : UA_Array_new(length, type);
+    if(data == nullptr) {
+      return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    if(scalar) {
+      UA_Variant_setScalar(&_val.value, data, type);
+    }
+    else {
+      UA_Variant_setArray(&_val.value, data, length, type);
+    }
+    _val.hasValue = true;
+    _clearData = true;
+    return UA_STATUSCODE_GOOD;
+  }
+
+  bool ManagedDataValue::reuseVariant(const UA_Variant& src) {
+    const UA_Variant& dst = _val.value;
+    if(!hasValue() || !_clearData || _val.status != UA_STATUSCODE_GOOD || dst.type != src.type ||
+        src.type == nullptr || !src.type->pointerFree || dst.storageType != UA_VARIANT_DATA ||
+        UA_Variant_isScalar(&dst) != UA_Variant_isScalar(&src) || dst.arrayLength != src.arrayLength ||
+        dst.arrayDimensionsSize != 0 || src.arrayDimensionsSize != 0 || dst.data == nullptr) {
+      return false;
+    }
+    size_t count = UA_Variant_isScalar(&src) ? 1 : src.arrayLength;
+    if(count > 0) {
+      // elements without pointers are overwritten in place, so nothing is allocated
+      std::memcpy(dst.data, src.data, count * src.type->memSize);
+    }
+    return true;
+  }
+
   void ManagedDataValue::prepare() {
     if(hasValue()) {
       UA_DataValue_clear(&_val);
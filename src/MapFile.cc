@@ -36,7 +36,10 @@ namespace ChimeraTK {
       if(reg == nullptr) {
         continue;
       }
-      if(reg->get_name() == "pv") {
+      if(reg->get_name() == "group") {
+        readGroup(reg);
+      }
+      else if(reg->get_name() == "pv") {
         node = reg->get_child_text()->get_content();
         auto* nsAttribute = reg->get_attribute("ns");
         if(nsAttribute) {
@@ -50,15 +53,125 @@ namespace ChimeraTK {
         if(rangeAttribute) {
           range = rangeAttribute->get_value();
         }
+        OpcUABackendRegisterOptions options;
+        auto* chunkSizeAttribute = reg->get_attribute("chunkSize");
+        auto* historyAttribute = reg->get_attribute("history");
+        auto* aggregateAttribute = reg->get_attribute("aggregate");
+        auto* aggregateIntervalAttribute = reg->get_attribute("aggregateInterval");
+        auto* aggregateSamplesAttribute = reg->get_attribute("aggregateSamples");
+        auto* publisherIdAttribute = reg->get_attribute("publisherId");
+        auto* writerGroupIdAttribute = reg->get_attribute("writerGroupId");
+        auto* dataSetWriterIdAttribute = reg->get_attribute("dataSetWriterId");
+        auto* dataSetFieldAttribute = reg->get_attribute("dataSetField");
+        auto* priorityAttribute = reg->get_attribute("priority");
+        auto* backfillAttribute = reg->get_attribute("backfill");
+        auto* modeAttribute = reg->get_attribute("mode");
+        auto* rateAttribute = reg->get_attribute("rate");
+        auto* maxAgeAttribute = reg->get_attribute("maxAge");
+        try {
+          if(chunkSizeAttribute) {
+            options.chunkSize = std::stoul(chunkSizeAttribute->get_value());
+          }
+          if(historyAttribute) {
+            options.historyLength = std::stoul(historyAttribute->get_value());
+          }
+          if(aggregateAttribute) {
+            options.aggregate = aggregateFromString(aggregateAttribute->get_value());
+          }
+          if(aggregateIntervalAttribute) {
+            options.aggregateInterval = std::stod(aggregateIntervalAttribute->get_value());
+          }
+          if(aggregateSamplesAttribute) {
+            options.aggregateSamples = std::stoul(aggregateSamplesAttribute->get_value());
+          }
+          if(publisherIdAttribute) {
+            options.publisherId = std::stoul(publisherIdAttribute->get_value());
+          }
+          if(writerGroupIdAttribute) {
+            options.writerGroupId = std::stoul(writerGroupIdAttribute->get_value());
+          }
+          if(dataSetWriterIdAttribute) {
+            options.dataSetWriterId = std::stoul(dataSetWriterIdAttribute->get_value());
+          }
+          if(dataSetFieldAttribute) {
+            options.dataSetField = std::stoul(dataSetFieldAttribute->get_value());
+          }
+          if(backfillAttribute) {
+            options.backfillLength = std::stoul(backfillAttribute->get_value());
+          }
+          if(modeAttribute) {
+            if(modeAttribute->get_value() == "poll") {
+              options.pollInterval = rateAttribute ? std::stoul(rateAttribute->get_value()) : 0;
+              if(options.pollInterval == 0) {
+                throw std::invalid_argument("Poll mode needs a rate.");
+              }
+            }
+            else if(modeAttribute->get_value() != "subscribe") {
+              throw std::invalid_argument("Unknown mode: " + modeAttribute->get_value());
+            }
+          }
+          if(maxAgeAttribute) {
+            options.maxAge = std::stod(maxAgeAttribute->get_value());
+            if(options.maxAge < 0) {
+              throw std::invalid_argument("Negative maxAge.");
+            }
+          }
+          if(priorityAttribute) {
+            if(priorityAttribute->get_value() == "high") {
+              options.highPriority = true;
+            }
+            else if(priorityAttribute->get_value() != "normal") {
+              throw std::invalid_argument("Unknown priority: " + priorityAttribute->get_value());
+            }
+          }
+        }
+        catch(std::logic_error& e) {
+          UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "Failed reading line %d from opcua map file %s (Invalid register option).", reg->get_line(),
+              _file.c_str());
+          continue;
+        }
+        if(options.aggregate != OpcUAAggregateType::none &&
+            (options.historyLength > 0 || (options.aggregateInterval <= 0 && options.aggregateSamples == 0))) {
+          UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "Failed reading line %d from opcua map file %s (Aggregates need aggregateInterval or aggregateSamples "
+              "and can not be combined with history).",
+              reg->get_line(), _file.c_str());
+          continue;
+        }
+        if(options.usesPubSub() && (options.historyLength > 0 || options.aggregate != OpcUAAggregateType::none)) {
+          UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "Failed reading line %d from opcua map file %s (PubSub registers can not be combined with history or "
+              "aggregates).",
+              reg->get_line(), _file.c_str());
+          continue;
+        }
+        if(options.backfillLength > 0 &&
+            (options.chunkSize > 0 || options.aggregate != OpcUAAggregateType::none || options.usesPubSub())) {
+          UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "Failed reading line %d from opcua map file %s (Backfill can not be combined with chunkSize, aggregates "
+              "or PubSub).",
+              reg->get_line(), _file.c_str());
+          continue;
+        }
+        if(options.usesPolling() &&
+            (options.chunkSize > 0 || options.historyLength > 0 || options.aggregate != OpcUAAggregateType::none ||
+                options.usesPubSub() || options.backfillLength > 0 || options.highPriority)) {
+          UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "Failed reading line %d from opcua map file %s (Poll mode can not be combined with chunkSize, history, "
+              "aggregates, PubSub, backfill or high priority).",
+              reg->get_line(), _file.c_str());
+          continue;
+        }
         try {
           UA_UInt32 id = std::stoul(node);
           UA_UInt16 ns = std::stoul(nsString);
-          elements.emplace_back(MapElement(id, ns, range, name));
+          elements.emplace_back(MapElement(id, ns, range, name, options));
         }
         catch(std::invalid_argument& e) {
           try {
             UA_UInt16 ns = std::stoul(nsString);
-            elements.emplace_back(MapElement(_serverRootNode + node, ns, range, name));
+            elements.emplace_back(MapElement(_serverRootNode + node, ns, range, name, options));
           }
           catch(std::invalid_argument& innerError) {
             UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
@@ -79,10 +192,78 @@ namespace ChimeraTK {
     }
   }
 
-  MapElement::MapElement(const UA_UInt32& id, const UA_UInt16& ns, const std::string& range, const std::string& name)
-  : _iNode(id), _namespace(ns), _node(UA_NODEID_NUMERIC(ns, id)), _range(range), _name(name) {}
-  MapElement::MapElement(const std::string& id, const UA_UInt16& ns, const std::string& range, const std::string& name)
-  : _strNode(id), _namespace(ns), _range(range), _name(name) {
+  void OPCUAMapFileReader::readGroup(const xmlpp::Element* group) {
+    auto* nsAttribute = group->get_attribute("ns");
+    auto* nameAttribute = group->get_attribute("name");
+    auto* priorityAttribute = group->get_attribute("priority");
+    auto* maxAgeAttribute = group->get_attribute("maxAge");
+    if(nameAttribute == nullptr || nameAttribute->get_value().empty()) {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed reading line %d from opcua map file %s (Groups need a name).", group->get_line(), _file.c_str());
+      return;
+    }
+    OpcUABackendRegisterOptions options;
+    std::vector<MapElement> channels;
+    try {
+      if(maxAgeAttribute) {
+        options.maxAge = std::stod(maxAgeAttribute->get_value());
+        if(options.maxAge < 0) {
+          throw std::invalid_argument("Negative maxAge.");
+        }
+      }
+      if(priorityAttribute) {
+        if(priorityAttribute->get_value() == "high") {
+          options.highPriority = true;
+        }
+        else if(priorityAttribute->get_value() != "normal") {
+          throw std::invalid_argument("Unknown priority: " + priorityAttribute->get_value());
+        }
+      }
+      for(auto* const i : group->get_children("node")) {
+        const auto* channel = dynamic_cast<const xmlpp::Element*>(i);
+        if(channel == nullptr || !channel->has_child_text()) {
+          throw std::invalid_argument("Empty node.");
+        }
+        std::string node = channel->get_child_text()->get_content();
+        // the namespace of the group is used if the node does not have its own
+        auto* channelNsAttribute = channel->get_attribute("ns");
+        std::string nsString = channelNsAttribute ? channelNsAttribute->get_value() :
+                                                    (nsAttribute ? nsAttribute->get_value() : std::string());
+        UA_UInt16 ns = std::stoul(nsString);
+        try {
+          UA_UInt32 id = std::stoul(node);
+          channels.emplace_back(id, ns, "", "");
+        }
+        catch(std::invalid_argument& e) {
+          channels.emplace_back(_serverRootNode + node, ns, "", "");
+        }
+      }
+    }
+    catch(std::logic_error& e) {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed reading line %d from opcua map file %s (Invalid group option or node).", group->get_line(),
+          _file.c_str());
+      return;
+    }
+    if(channels.empty()) {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed reading line %d from opcua map file %s (Group without nodes).", group->get_line(), _file.c_str());
+      return;
+    }
+    // the first node identifies the register, e.g. for error reporting
+    MapElement element(channels.front());
+    element._name = nameAttribute->get_value();
+    element._options = options;
+    element._channels = std::move(channels);
+    elements.emplace_back(std::move(element));
+  }
+
+  MapElement::MapElement(const UA_UInt32& id, const UA_UInt16& ns, const std::string& range, const std::string& name,
+      const OpcUABackendRegisterOptions& options)
+  : _iNode(id), _namespace(ns), _node(UA_NODEID_NUMERIC(ns, id)), _range(range), _name(name), _options(options) {}
+  MapElement::MapElement(const std::string& id, const UA_UInt16& ns, const std::string& range, const std::string& name,
+      const OpcUABackendRegisterOptions& options)
+  : _strNode(id), _namespace(ns), _range(range), _name(name), _options(options) {
     _node = UA_NODEID_STRING_ALLOC(ns, _strNode.c_str());
   }
 
@@ -92,7 +273,7 @@ namespace ChimeraTK {
 
   MapElement::MapElement(const MapElement& other)
   : _namespace(other._namespace), _strNode(other._strNode), _iNode(other._iNode), _range(other._range),
-    _name(other._name) {
+    _name(other._name), _options(other._options), _channels(other._channels) {
     UA_NodeId_copy(&other._node, &_node);
   }
 
@@ -104,6 +285,8 @@ namespace ChimeraTK {
       _iNode = other._iNode;
       _range = other._range;
       _name = other._name;
+      _options = other._options;
+      _channels = other._channels;
       UA_NodeId_copy(&other._node, &_node);
     }
     return *this;
@@ -111,7 +294,8 @@ namespace ChimeraTK {
 
   MapElement::MapElement(MapElement&& other) noexcept
   : _namespace(other._namespace), _strNode(std::move(other._strNode)), _iNode(other._iNode), _node(other._node),
-    _range(std::move(other._range)), _name(std::move(other._name)) {
+    _range(std::move(other._range)), _name(std::move(other._name)), _options(other._options),
+    _channels(std::move(other._channels)) {
     UA_NodeId_init(&other._node); // Reset source so it won't free our data
   }
 
@@ -124,6 +308,8 @@ namespace ChimeraTK {
       _node = other._node;
       _range = std::move(other._range);
       _name = std::move(other._name);
+      _options = other._options;
+      _channels = std::move(other._channels);
       UA_NodeId_init(&other._node); // Reset source
     }
     return *this;
@@ -27,7 +27,9 @@
 #include <boost/tokenizer.hpp>
 
 #include <fstream>
+#include <limits>
 #include <string>
+#include <unordered_set>
 
 using tokenizer = boost::tokenizer<boost::char_separator<char>>;
 
@@ -42,8 +44,9 @@ namespace ChimeraTK {
       UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "No client found in the stateCallback.");
       return;
     }
-    OpcUABackend::backendClients[client]->_connection->channelState = channelState;
-    OpcUABackend::backendClients[client]->_connection->sessionState = sessionState;
+    auto [connection, subscriptionManager] = OpcUABackend::backendClients[client]->getLane(client);
+    connection->channelState = channelState;
+    connection->sessionState = sessionState;
     switch(channelState) {
       case UA_SECURECHANNELSTATE_CLOSED:
         UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "The client is disconnected");
@@ -109,11 +112,9 @@ namespace ChimeraTK {
     }
     // when closing the device this does not need to be done
     if(OpcUABackend::backendClients[client]->_opened) {
-      if(!OpcUABackend::backendClients[client]->_connection->isConnected() &&
-          OpcUABackend::backendClients[client]->_subscriptionManager) {
-        if(OpcUABackend::backendClients[client]->_subscriptionManager->isRunning()) {
-          OpcUABackend::backendClients[client]->_subscriptionManager->deactivateAllAndPushException(
-              "Client session is not open any more.");
+      if(!connection->isConnected() && subscriptionManager) {
+        if(subscriptionManager->isRunning()) {
+          subscriptionManager->deactivateAllAndPushException("Client session is not open any more.");
         }
       }
     }
@@ -122,19 +123,18 @@ namespace ChimeraTK {
   void OpcUABackend::inactivityCallback(UA_Client* client, UA_UInt32 subId, void* /*subContext*/) {
     // when closing the device this does not need to be done
     if(OpcUABackend::backendClients[client]->isFunctional()) {
-      if(OpcUABackend::backendClients[client]->_connection->isConnected() &&
-          OpcUABackend::backendClients[client]->_subscriptionManager) {
-        if(OpcUABackend::backendClients[client]->_subscriptionManager->isRunning() &&
-            OpcUABackend::backendClients[client]->_subscriptionManager->getSubscriptionID() == subId) {
+      auto [connection, subscriptionManager] = OpcUABackend::backendClients[client]->getLane(client);
+      if(connection->isConnected() && subscriptionManager) {
+        if(subscriptionManager->isRunning() && subscriptionManager->getSubscriptionID() == subId) {
           std::stringstream ss;
           ss << "No activity for subscriptions: " << subId;
-          OpcUABackend::backendClients[client]->_subscriptionManager->deactivateAllAndPushException(ss.str());
+          subscriptionManager->deactivateAllAndPushException(ss.str());
           /*
            *  Manually set session state to closed.
            *  When backend is recovered a new session will be created and thus the sessionState will be
            *  updated accordingly.
            */
-          OpcUABackend::backendClients[client]->_connection->sessionState = UA_SessionState::UA_SESSIONSTATE_CLOSED;
+          connection->sessionState = UA_SessionState::UA_SESSIONSTATE_CLOSED;
         }
       }
     }
@@ -144,15 +144,41 @@ namespace ChimeraTK {
       const std::string& mapfile, const double& subscriptionPublishingInterval, const std::string& rootNode,
       const ulong& rootNS, const uint32_t& connectionTimeout, const UA_LogLevel& logLevel,
       const std::string& certificate, const std::string& privateKey, const bool& trustAny,
-      const std::string& trustListFolder, const std::string& revocationListFolder, const std::string& cacheFile)
-  : _subscriptionManager(nullptr), _catalogue_filled(false), _mapfile(mapfile), _rootNode(rootNode), _rootNS(rootNS) {
+      const std::string& trustListFolder, const std::string& revocationListFolder, const std::string& cacheFile,
+      const SubscriptionSettings& subscriptionSettings, const PubSubSettings& pubSubSettings,
+      const PriorityLaneSettings& prioritySettings, const HealthMonitorSettings& healthSettings,
+      const bool& registerNodes, const double& maxAge, const size_t& maxPendingWrites,
+      const uint32_t& maxMessageSize)
+  : _subscriptionManager(nullptr), _pubSubSettings(pubSubSettings), _catalogue_filled(false), _mapfile(mapfile),
+    _rootNode(rootNode), _rootNS(rootNS) {
     backendLogger = UA_Log_Stdout_withLevel(logLevel);
     _connection = std::make_unique<OPCUAConnection>(fileAddress, username, password, subscriptionPublishingInterval,
         connectionTimeout, logLevel, certificate, privateKey, trustAny, trustListFolder, revocationListFolder);
+    _connection->subscriptionSettings = subscriptionSettings;
+    _connection->useRegisteredNodes = registerNodes;
+    _connection->maxAge = maxAge;
+    if(maxMessageSize > 0) {
+      _connection->config->localConnectionConfig.localMaxMessageSize = maxMessageSize;
+    }
+#ifndef UA_ENABLE_PUBSUB
+    if(_pubSubSettings.enabled()) {
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "open62541 was built without PubSub support. All registers are received via the subscription.");
+      _pubSubSettings = {};
+    }
+#endif
     _connection->config->stateCallback = stateCallback;
     _connection->config->subscriptionInactivityCallback = inactivityCallback;
 
     OpcUABackend::backendClients[_connection->client.get()] = this;
+    if(healthSettings.enabled()) {
+      _healthMonitor = std::make_unique<OPCUAHealthMonitor>(
+          _connection, healthSettings, [this](const std::string& message) { connectionLost(message); });
+    }
+    if(maxPendingWrites > 0) {
+      _asyncWriter = std::make_unique<OPCUAAsyncWriter>(
+          _connection, maxPendingWrites, [this](const std::string& message) { setException(message); });
+    }
     FILL_VIRTUAL_FUNCTION_TEMPLATE_VTABLE(getRegisterAccessor_impl);
     /* Registers are added before open() is called in ApplicationCore.
      * Since in the registration the catalog is needed we connect already
@@ -176,9 +202,50 @@ namespace ChimeraTK {
         fillCatalogue(cacheFile);
       }
     }
+
+    bool hasPriorityRegisters = false;
+    for(auto it = _catalogue_mutable.begin(), ite = _catalogue_mutable.end(); it != ite; it++) {
+      if(dynamic_cast<OpcUABackendRegisterInfo*>(&(*it))->options.highPriority) {
+        hasPriorityRegisters = true;
+        break;
+      }
+    }
+    if(hasPriorityRegisters) {
+      double priorityPublishingInterval = prioritySettings.publishingInterval > 0 ?
+          prioritySettings.publishingInterval :
+          subscriptionPublishingInterval;
+      UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Setting up priority lane with publishing interval of %fms.", priorityPublishingInterval);
+      _priorityConnection = std::make_unique<OPCUAConnection>(fileAddress, username, password,
+          priorityPublishingInterval, connectionTimeout, logLevel, certificate, privateKey, trustAny, trustListFolder,
+          revocationListFolder);
+      _priorityConnection->subscriptionSettings = subscriptionSettings;
+      _priorityConnection->realtimePriority = prioritySettings.realtimePriority;
+      _priorityConnection->useRegisteredNodes = registerNodes;
+      _priorityConnection->maxAge = maxAge;
+      _priorityConnection->config->localConnectionConfig = _connection->config->localConnectionConfig;
+      _priorityConnection->config->stateCallback = stateCallback;
+      _priorityConnection->config->subscriptionInactivityCallback = inactivityCallback;
+      OpcUABackend::backendClients[_priorityConnection->client.get()] = this;
+      if(maxPendingWrites > 0) {
+        _priorityAsyncWriter = std::make_unique<OPCUAAsyncWriter>(
+            _priorityConnection, maxPendingWrites, [this](const std::string& message) { setException(message); });
+      }
+      // if the catalogue was read from the cache file the connection is established in open()
+      if(_connection->isConnected()) {
+        connectClient(*_priorityConnection);
+      }
+    }
+    if(_connection->isConnected()) {
+      registerNodes();
+      resolveStructureTypes();
+    }
   }
 
   OpcUABackend::~OpcUABackend() {
+    if(_healthMonitor) {
+      _healthMonitor->stop();
+    }
     if(_opened) {
       close();
     }
@@ -232,11 +299,20 @@ namespace ChimeraTK {
         throw ChimeraTK::runtime_error("No elements found in the map file!");
       }
       for(const auto& element : reader.elements) {
-        if(element._name.empty()) {
-          addCatalogueEntry(element._node, nullptr, element._range);
+        if(!element._channels.empty()) {
+          std::vector<UA_NodeId> nodes;
+          for(const auto& channel : element._channels) {
+            // the node ids are only borrowed from the map file reader
+            nodes.push_back(channel._node);
+          }
+          addChannelGroup(nodes, element._name, element._options);
+        }
+        else if(element._name.empty()) {
+          addCatalogueEntry(element._node, nullptr, element._range, element._options);
         }
         else {
-          addCatalogueEntry(element._node, std::make_shared<std::string>(element._name), element._range);
+          addCatalogueEntry(
+              element._node, std::make_shared<std::string>(element._name), element._range, element._options);
         }
       }
       UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
@@ -348,8 +424,8 @@ namespace ChimeraTK {
     _catalogue_filled = true;
   }
 
-  void OpcUABackend::addCatalogueEntry(
-      const UA_NodeId& node, const std::shared_ptr<std::string>& nodeName, const std::string& range) {
+  void OpcUABackend::addCatalogueEntry(const UA_NodeId& node, const std::shared_ptr<std::string>& nodeName,
+      const std::string& range, const OpcUABackendRegisterOptions& options) {
     // connection is locked in fillCatalogue
     std::string description;
     UA_UInt32 dataType;
@@ -391,9 +467,15 @@ namespace ChimeraTK {
           localNodeName.c_str(), UA_StatusCode_name(retval));
       return;
     }
+    if(id->namespaceIndex != 0 || id->identifierType != UA_NODEIDTYPE_NUMERIC || id->identifier.numeric > 25) {
+      // no built-in type - the node might be a structure
+      addStructureEntries(node, localNodeName, *id, range, options);
+      UA_NodeId_delete(id);
+      return;
+    }
     dataType = id->identifier.numeric;
     UA_NodeId_delete(id);
-    if(dataType > 12 || dataType < 1) {
+    if((dataType > 12 && dataType != 15 /*ByteString*/) || dataType < 1) {
       UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
           "Failed to determine data type for node: %s  -> entry is not added to the catalogue.", localNodeName.c_str());
       return;
@@ -414,6 +496,25 @@ namespace ChimeraTK {
 
     UA_Variant* val = UA_Variant_new();
     retval = UA_Client_readValueAttribute(_connection->client.get(), node, val);
+    // length of arrays that are too large for a single message - they are transferred in pages
+    size_t valueLength = 0;
+    // rows of two-dimensional nodes, which are mapped to channels - 0 for nodes with one dimension
+    size_t numberOfChannels = 0;
+    if((retval == UA_STATUSCODE_BADRESPONSETOOLARGE || retval == UA_STATUSCODE_BADENCODINGLIMITSEXCEEDED) &&
+        dataType != 15 /*ByteString*/) {
+      size_t dimensionsSize = 0;
+      UA_UInt32* dimensions = nullptr;
+      if(UA_Client_readArrayDimensionsAttribute(_connection->client.get(), node, &dimensionsSize, &dimensions) ==
+              UA_STATUSCODE_GOOD &&
+          dimensionsSize == 1 && dimensions[0] > 0) {
+        valueLength = dimensions[0];
+        retval = UA_STATUSCODE_GOOD;
+      }
+      UA_Array_delete(dimensions, dimensionsSize, &UA_TYPES[UA_TYPES_UINT32]);
+    }
+    else {
+      valueLength = val->arrayLength;
+    }
     if(retval != UA_STATUSCODE_GOOD) {
       UA_Variant_delete(val);
       UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
@@ -421,18 +522,61 @@ namespace ChimeraTK {
           localNodeName.c_str(), UA_StatusCode_name(retval));
       return;
     }
-    if(UA_Variant_isScalar(val)) {
+    if(dataType == 15 /*ByteString*/) {
+      // the bytes of all blobs are the elements of the register - their number is fixed when creating the catalogue
+      arrayLength = forEachByteStringSegment(*val, 0, std::numeric_limits<size_t>::max(), [](auto...) {});
+      if(arrayLength == 0 || !range.empty() || options.chunkSize > 0 || options.historyLength > 0 ||
+          options.aggregate != OpcUAAggregateType::none) {
+        UA_Variant_delete(val);
+        UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "ByteString variable: %s is empty or uses a range, chunks, history or aggregates, which is not supported. "
+            "Variable is not added to the catalog.",
+            localNodeName.c_str());
+        return;
+      }
+    }
+    else if(UA_Variant_isScalar(val)) {
       arrayLength = 1;
     }
-    else if(val->arrayLength == 0) {
+    else if(valueLength == 0) {
       UA_Variant_delete(val);
       UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
           "Array length of variable: %s  is 0!. Variable is not added to the catalog.", localNodeName.c_str());
       return;
     }
+    else if(val->arrayDimensionsSize > 1) {
+      bool supported = val->arrayDimensionsSize == 2 && options.chunkSize == 0 && options.historyLength == 0 &&
+          options.aggregate == OpcUAAggregateType::none && !options.usesPubSub();
+      if(supported) {
+        numberOfChannels = val->arrayDimensions[0];
+        arrayLength = val->arrayDimensions[1];
+      }
+      if(supported && !range.empty()) {
+        // the range has one dimension per node dimension, e.g. "1:2,0:9" for the first ten elements of rows 1 and 2
+        auto uaRange = UA_NUMERICRANGE(range.c_str());
+        supported = uaRange.dimensionsSize == 2 && uaRange.dimensions[0].max < numberOfChannels &&
+            uaRange.dimensions[1].max < arrayLength;
+        if(supported) {
+          numberOfChannels = (uaRange.dimensions[0].max - uaRange.dimensions[0].min) + 1;
+          arrayLength = (uaRange.dimensions[1].max - uaRange.dimensions[1].min) + 1;
+        }
+        UA_free(uaRange.dimensions);
+      }
+      if(!supported || numberOfChannels * arrayLength == 0) {
+        UA_Variant_delete(val);
+        UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Multi-dimensional variable: %s has more than two dimensions, an invalid range %s or uses chunks, "
+            "history, aggregates or PubSub, which is not supported. Variable is not added to the catalog.",
+            localNodeName.c_str(), range.c_str());
+        return;
+      }
+      UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Variable: %s is mapped to %zu channels of %zu elements.", localNodeName.c_str(), numberOfChannels,
+          arrayLength);
+    }
     else {
       if(range.empty()) {
-        arrayLength = val->arrayLength;
+        arrayLength = valueLength;
       }
       else {
         auto uaRange = UA_NUMERICRANGE(range.c_str());
@@ -460,15 +604,186 @@ namespace ChimeraTK {
       return;
     }
     isReadonly = !(accessLevel & UA_ACCESSLEVELMASK_WRITE);
-    _catalogue_mutable.addProperty(
-        node, localNodeName, range, dataType, arrayLength, _connection->serverAddress, description, isReadonly);
+    if(options.aggregate != OpcUAAggregateType::none) {
+      // aggregates are computed from the subscription and can not be written
+      isReadonly = true;
+      if(options.aggregate == OpcUAAggregateType::count) {
+        dataType = 7; /*UInt32*/
+      }
+      else if(options.aggregate != OpcUAAggregateType::last) {
+        if(dataType == 12 /*String*/) {
+          UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "Aggregate %s is not supported for string variable: %s. Variable is not added to the catalog.",
+              toString(options.aggregate).c_str(), localNodeName.c_str());
+          return;
+        }
+        dataType = 11; /*Double*/
+      }
+    }
+    _catalogue_mutable.addProperty(node, localNodeName, range, dataType, arrayLength, _connection->serverAddress,
+        description, isReadonly, options, OpcUAHistoryContent::none, numberOfChannels);
+    if(options.historyLength > 0) {
+      if(arrayLength != 1) {
+        UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "History is only supported for scalar nodes. No history registers are added for: %s",
+            localNodeName.c_str());
+        return;
+      }
+      _catalogue_mutable.addProperty(node, localNodeName + "/history", range, dataType, options.historyLength,
+          _connection->serverAddress, description, true, options, OpcUAHistoryContent::values);
+      // the time stamps are converted from UA_DateTime to Int64 in MonitorItem::push()
+      _catalogue_mutable.addProperty(node, localNodeName + "/historyTimestamps", range,
+          UA_TYPES[UA_TYPES_INT64].typeId.identifier.numeric, options.historyLength, _connection->serverAddress,
+          "Source time stamps in ns since the Unix epoch", true, options, OpcUAHistoryContent::timestamps);
+    }
+  }
+
+  void OpcUABackend::addChannelGroup(
+      const std::vector<UA_NodeId>& nodes, const std::string& nodeName, const OpcUABackendRegisterOptions& options) {
+    // connection is locked in fillCatalogue
+    UA_UInt32 dataType{0};
+    size_t arrayLength{0};
+    bool isReadonly{false};
+    std::string description;
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      const UA_NodeId& node = nodes[i];
+      std::string problem;
+      UA_NodeId typeId;
+      UA_NodeId_init(&typeId);
+      UA_Variant val;
+      UA_Variant_init(&val);
+      UA_Byte accessLevel{0};
+      UA_StatusCode retval = UA_Client_readDataTypeAttribute(_connection->client.get(), node, &typeId);
+      if(retval == UA_STATUSCODE_GOOD) {
+        retval = UA_Client_readValueAttribute(_connection->client.get(), node, &val);
+      }
+      if(retval == UA_STATUSCODE_GOOD) {
+        retval = UA_Client_readAccessLevelAttribute(_connection->client.get(), node, &accessLevel);
+      }
+      size_t length = UA_Variant_isScalar(&val) ? 1 : val.arrayLength;
+      if(retval != UA_STATUSCODE_GOOD) {
+        problem = UA_StatusCode_name(retval);
+      }
+      else if(typeId.namespaceIndex != 0 || typeId.identifierType != UA_NODEIDTYPE_NUMERIC ||
+          typeId.identifier.numeric < 1 || typeId.identifier.numeric > 12) {
+        problem = "data type not supported";
+      }
+      else if(val.arrayDimensionsSize > 1 || length == 0) {
+        problem = "empty or multi-dimensional node";
+      }
+      else if(i > 0 && (typeId.identifier.numeric != dataType || length != arrayLength)) {
+        problem = "data type or length differs from the first node";
+      }
+      if(problem.empty() && i == 0) {
+        dataType = typeId.identifier.numeric;
+        arrayLength = length;
+        UA_LocalizedText text;
+        UA_LocalizedText_init(&text);
+        if(UA_Client_readDescriptionAttribute(_connection->client.get(), node, &text) == UA_STATUSCODE_GOOD) {
+          description = std::string((char*)text.text.data, text.text.length);
+        }
+        UA_LocalizedText_clear(&text);
+      }
+      isReadonly = isReadonly || !(accessLevel & UA_ACCESSLEVELMASK_WRITE);
+      UA_NodeId_clear(&typeId);
+      UA_Variant_clear(&val);
+      if(!problem.empty()) {
+        UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Failed to add channel %zu of group: %s (%s). Group is not added to the catalog.", i, nodeName.c_str(),
+            problem.c_str());
+        return;
+      }
+    }
+    UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+        "Group: %s is mapped to %zu channels of %zu elements.", nodeName.c_str(), nodes.size(), arrayLength);
+    _catalogue_mutable.addChannelGroup(
+        nodes, nodeName, dataType, arrayLength, _connection->serverAddress, description, isReadonly, options);
+  }
+
+  void OpcUABackend::addStructureEntries(const UA_NodeId& node, const std::string& nodeName, const UA_NodeId& typeId,
+      const std::string& range, const OpcUABackendRegisterOptions& options) {
+    // connection is locked in fillCatalogue
+    std::shared_ptr<const OPCUAStructureType> structure;
+    try {
+      structure = getStructureType(typeId);
+    }
+    catch(ChimeraTK::runtime_error& e) {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed to determine data type for node: %s (%s) -> entry is not added to the catalogue.", nodeName.c_str(),
+          e.what());
+      return;
+    }
+    if(!range.empty() || options.chunkSize > 0 || options.historyLength > 0 ||
+        options.aggregate != OpcUAAggregateType::none) {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Structure variable: %s uses a range, chunks, history or aggregates, which is not supported. Variable is not "
+          "added to the catalog.",
+          nodeName.c_str());
+      return;
+    }
+    UA_String typeName = UA_STRING_NULL;
+    UA_NodeId_print(&typeId, &typeName);
+    std::string structureType((char*)typeName.data, typeName.length);
+    UA_String_clear(&typeName);
+    const auto& fields = structure->getFields();
+    for(size_t i = 0; i < fields.size(); ++i) {
+      const UA_NodeId& fieldType = fields[i].type->typeId;
+      // only scalar fields with a type supported by the accessors get a register
+      if(fields[i].isArray || fieldType.namespaceIndex != 0 || fieldType.identifier.numeric > 12) {
+        UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Field %s of structure variable: %s is not added to the catalog.", fields[i].name.c_str(),
+            nodeName.c_str());
+        continue;
+      }
+      _catalogue_mutable.addStructureField(node, nodeName + "/" + fields[i].name, fieldType.identifier.numeric,
+          _connection->serverAddress, "", options, structureType, i, structure);
+    }
+  }
+
+  std::shared_ptr<const OPCUAStructureType> OpcUABackend::getStructureType(const UA_NodeId& typeId) {
+    // several nodes might use the same type
+    for(auto& type : _structureTypes) {
+      if(UA_NodeId_equal(&type->getTypeId(), &typeId)) {
+        return type;
+      }
+    }
+    _structureTypes.push_back(OPCUAStructureType::read(*_connection, typeId));
+    return _structureTypes.back();
+  }
+
+  void OpcUABackend::resolveStructureTypes() {
+    std::lock_guard<std::mutex> lock(_connection->client_lock);
+    for(auto it = _catalogue_mutable.begin(), ite = _catalogue_mutable.end(); it != ite; it++) {
+      auto* info = dynamic_cast<OpcUABackendRegisterInfo*>(&(*it));
+      // the decoder is kept when reconnecting, since the data type does not change
+      if(!info->isStructureField() || info->structure) {
+        continue;
+      }
+      UA_NodeId typeId;
+      if(UA_NodeId_parse(&typeId, UA_STRING(const_cast<char*>(info->structureType.c_str()))) != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Invalid structure type %s of register: %s.", info->structureType.c_str(), info->nodeBrowseName.c_str());
+        continue;
+      }
+      try {
+        info->structure = getStructureType(typeId);
+      }
+      catch(ChimeraTK::runtime_error& e) {
+        UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Failed to read structure type %s of register: %s (%s).", info->structureType.c_str(),
+            info->nodeBrowseName.c_str(), e.what());
+      }
+      UA_NodeId_clear(&typeId);
+    }
   }
 
   void OpcUABackend::resetClient() {
-    if(_subscriptionManager) {
-      _subscriptionManager->deactivate();
-      _subscriptionManager->resetMonitoredItems();
-      _subscriptionManager->stopClientThread();
+    for(auto& manager : {_subscriptionManager, _prioritySubscriptionManager}) {
+      if(manager) {
+        manager->deactivate();
+        manager->resetMonitoredItems();
+        manager->stopClientThread();
+      }
     }
     /*
      *  close connection
@@ -478,9 +793,11 @@ namespace ChimeraTK {
      *  By closing the session we force an initial value to be send when reconnecting the
      *  client.
      */
-    {
-      std::lock_guard<std::mutex> lock(_connection->client_lock);
-      _connection->close();
+    for(auto& connection : {_connection, _priorityConnection}) {
+      if(connection) {
+        std::lock_guard<std::mutex> lock(connection->client_lock);
+        connection->close();
+      }
     }
   }
 
@@ -495,32 +812,68 @@ namespace ChimeraTK {
     // not called but in the tests the device is reset without calling read in between -> so we need to check the
     // connection here
     // -> to make sure the Subscription internal thread is stopped.
-    if(!_connection->isConnected()) {
+    auto isConnected = [&] {
+      return _connection->isConnected() && (!_priorityConnection || _priorityConnection->isConnected());
+    };
+    // writes of the previous session are sent or dropped before the device is recovered
+    for(auto* writer : {_asyncWriter.get(), _priorityAsyncWriter.get()}) {
+      if(writer) {
+        writer->stop();
+      }
+    }
+    if(!isConnected()) {
       UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Opening the device: %s",
           _connection->serverAddress.c_str());
-      if(_subscriptionManager) {
-        _subscriptionManager->stopClientThread();
+      for(auto& manager : {_subscriptionManager, _prioritySubscriptionManager}) {
+        if(manager) {
+          manager->stopClientThread();
+        }
       }
       connect();
     }
 
     // wait at maximum 100ms for the client to come up
     uint i = 0;
-    while(!_connection->isConnected()) {
+    while(!isConnected()) {
       std::this_thread::sleep_for(std::chrono::milliseconds(20));
       ++i;
       if(i > 4) {
         throw ChimeraTK::runtime_error("Connection could not be established.");
       }
     }
+    if(_healthMonitor) {
+      _healthMonitor->start();
+    }
+    for(auto* writer : {_asyncWriter.get(), _priorityAsyncWriter.get()}) {
+      if(writer) {
+        writer->start();
+      }
+    }
     setOpenedAndClearException();
   }
 
   void OpcUABackend::close() {
     _opened = false;
+    if(_healthMonitor) {
+      _healthMonitor->stop();
+    }
     UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Closing the device: %s",
         _connection->serverAddress.c_str());
+    // queued writes are sent before the session is closed
+    for(auto* writer : {_asyncWriter.get(), _priorityAsyncWriter.get()}) {
+      if(writer) {
+        writer->stop();
+      }
+    }
     resetClient();
+    if(_pollScheduler) {
+      _pollScheduler->deactivate("");
+    }
+#ifdef UA_ENABLE_PUBSUB
+    if(_pubSubSubscriber) {
+      _pubSubSubscriber->deactivate("");
+    }
+#endif
     //\ToDo: Check if we should reset the catalogue after closing. The UnifiedBackendTest will fail in that case.
     //    _catalogue_mutable = RegisterCatalogue();
     //    _catalogue_filled = false;
@@ -528,35 +881,127 @@ namespace ChimeraTK {
 
   void OpcUABackend::connect() {
     resetClient();
+    connectClient(*_connection);
+    // if already setup subscriptions where used
+    if(_subscriptionManager) {
+      _subscriptionManager->prepare();
+    }
+    if(_priorityConnection) {
+      connectClient(*_priorityConnection);
+      if(_prioritySubscriptionManager) {
+        _prioritySubscriptionManager->prepare();
+      }
+    }
+    if(_catalogue_filled) {
+      registerNodes();
+      resolveStructureTypes();
+    }
+  }
+
+  void OpcUABackend::registerNodes() {
+    for(auto& connection : {_connection, _priorityConnection}) {
+      if(!connection || !connection->useRegisteredNodes) {
+        continue;
+      }
+      // the node ids are only borrowed from the catalogue
+      std::vector<UA_NodeId> nodes;
+      std::unordered_set<UA_NodeId, NodeIdHash, NodeIdEqual> known;
+      for(auto it = _catalogue_mutable.begin(), ite = _catalogue_mutable.end(); it != ite; it++) {
+        auto* info = dynamic_cast<OpcUABackendRegisterInfo*>(&(*it));
+        if(getConnection(*info) != connection) {
+          continue;
+        }
+        // several registers might use the same node
+        if(known.insert(info->id).second) {
+          nodes.push_back(info->id);
+        }
+        for(const auto& channel : info->channelIds) {
+          if(known.insert(channel).second) {
+            nodes.push_back(channel);
+          }
+        }
+      }
+      std::lock_guard<std::mutex> lock(connection->client_lock);
+      connection->registerNodes(nodes);
+    }
+  }
+
+  void OpcUABackend::connectClient(OPCUAConnection& connection) {
     UA_StatusCode retval;
     {
-      std::lock_guard<std::mutex> lock(_connection->client_lock);
+      std::lock_guard<std::mutex> lock(connection.client_lock);
       /** Connect **/
-      if(!_connection->certificate.empty() && !_connection->key.empty()) {
-        retval = UA_Client_connect(_connection->client.get(), _connection->serverAddress.c_str());
+      if(!connection.certificate.empty() && !connection.key.empty()) {
+        retval = UA_Client_connect(connection.client.get(), connection.serverAddress.c_str());
       }
       else {
-        if(_connection->username.empty() || _connection->password.empty()) {
-          retval = UA_Client_connect(_connection->client.get(), _connection->serverAddress.c_str());
+        if(connection.username.empty() || connection.password.empty()) {
+          retval = UA_Client_connect(connection.client.get(), connection.serverAddress.c_str());
         }
         else {
-          retval = UA_Client_connectUsername(_connection->client.get(), _connection->serverAddress.c_str(),
-              _connection->username.c_str(), _connection->password.c_str());
+          retval = UA_Client_connectUsername(connection.client.get(), connection.serverAddress.c_str(),
+              connection.username.c_str(), connection.password.c_str());
         }
       }
     }
     if(retval != UA_STATUSCODE_GOOD) {
       std::stringstream ss;
-      ss << "Failed to connect to opc server: " << _connection->serverAddress
+      ss << "Failed to connect to opc server: " << connection.serverAddress
          << " with reason: " << UA_StatusCode_name(retval);
       throw ChimeraTK::runtime_error(ss.str());
     }
     UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Connection established:  %s ",
-        _connection->serverAddress.c_str());
-    // if already setup subscriptions where used
-    if(_subscriptionManager) {
-      _subscriptionManager->prepare();
+        connection.serverAddress.c_str());
+    {
+      // aliases registered in a previous session are not valid any more
+      std::lock_guard<std::mutex> lock(connection.client_lock);
+      connection.clearRegisteredNodes();
+    }
+  }
+
+  void OpcUABackend::connectionLost(const std::string& message) {
+    // when closing the device or if an exception is already reported this does not need to be done
+    if(!isFunctional()) {
+      return;
+    }
+    for(auto& manager : {_subscriptionManager, _prioritySubscriptionManager}) {
+      if(manager) {
+        manager->deactivateAllAndPushException(message);
+      }
+    }
+    if(_pollScheduler) {
+      _pollScheduler->deactivate(message);
+    }
+#ifdef UA_ENABLE_PUBSUB
+    if(_pubSubSubscriber) {
+      _pubSubSubscriber->deactivate(message);
     }
+#endif
+    // a new session is created when the device is recovered
+    for(auto& connection : {_connection, _priorityConnection}) {
+      if(connection) {
+        connection->sessionState = UA_SessionState::UA_SESSIONSTATE_CLOSED;
+      }
+    }
+    setException(message);
+  }
+
+  std::pair<std::shared_ptr<OPCUAConnection>, std::shared_ptr<OPCUASubscriptionManager>> OpcUABackend::getLane(
+      UA_Client* client) {
+    if(_priorityConnection && _priorityConnection->client.get() == client) {
+      return {_priorityConnection, _prioritySubscriptionManager};
+    }
+    return {_connection, _subscriptionManager};
+  }
+
+  size_t OpcUABackend::getNumberOfMonitoredItems() const {
+    size_t nItems = 0;
+    for(const auto& manager : {_subscriptionManager, _prioritySubscriptionManager}) {
+      if(manager) {
+        nItems += manager->getNumberOfMonitoredItems();
+      }
+    }
+    return nItems;
   }
 
   void OpcUABackend::activateAsyncRead() noexcept {
@@ -564,30 +1009,116 @@ namespace ChimeraTK {
     if(!isFunctional()) {
       return;
     }
-    if(!_subscriptionManager) {
-      _subscriptionManager = std::make_unique<OPCUASubscriptionManager>(_connection);
+    activateLane(_subscriptionManager, _connection);
+    if(_priorityConnection) {
+      activateLane(_prioritySubscriptionManager, _priorityConnection);
+    }
+    if(_pollScheduler) {
+      _pollScheduler->activate();
+    }
+    activatePubSub();
+  }
+
+  void OpcUABackend::activateLane(
+      std::shared_ptr<OPCUASubscriptionManager>& manager, const std::shared_ptr<OPCUAConnection>& connection) {
+    if(!manager) {
+      manager = std::make_unique<OPCUASubscriptionManager>(connection);
     }
-    _subscriptionManager->activate();
+    manager->activate();
 
     // Check if thread is already running-> happens if a second logicalNameMappingBackend is calling activateAsyncRead
     // after a first one called activateAsyncRead already
-    if(_subscriptionManager->opcuaThread == nullptr) {
-      _subscriptionManager->start();
-      // sleep twice the publishing interval to make sure initial values are written
-      std::this_thread::sleep_for(std::chrono::milliseconds(2 * (uint32_t)_connection->publishingInterval));
+    if(manager->opcuaThread == nullptr) {
+      manager->start();
+      // initial values not read by the subscription manager are sent with the first publish response
+      manager->waitForInitialValues();
+    }
+  }
+
+  void OpcUABackend::activatePubSub() noexcept {
+#ifdef UA_ENABLE_PUBSUB
+    if(!_pubSubSubscriber) {
+      return;
+    }
+    try {
+      _pubSubSubscriber->activate();
+    }
+    catch(ChimeraTK::runtime_error& e) {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "%s", e.what());
+      setException(e.what());
     }
+#endif
   }
 
-  void OpcUABackend::activateSubscriptionSupport() {
-    if(!_subscriptionManager) {
-      _subscriptionManager = std::make_unique<OPCUASubscriptionManager>(_connection);
+  void OpcUABackend::activateSubscriptionSupport(const OpcUABackendRegisterInfo& info) {
+    auto& manager = getSubscriptionManager(info);
+    if(!manager) {
+      manager = std::make_unique<OPCUASubscriptionManager>(getConnection(info));
+    }
+  }
+
+  bool OpcUABackend::subscribePubSub([[maybe_unused]] OpcUABackendRegisterAccessorBase* accessor) {
+#ifdef UA_ENABLE_PUBSUB
+    if(!_pubSubSettings.enabled() || !accessor->info->options.usesPubSub()) {
+      return false;
+    }
+    if(!_pubSubSubscriber) {
+      _pubSubSubscriber = std::make_unique<OPCUAPubSubSubscriber>(_pubSubSettings, _catalogue_mutable);
+    }
+    _pubSubSubscriber->subscribe(accessor);
+    if(_subscriptionManager && _subscriptionManager->isAsyncReadActive()) {
+      // async read was activated before the first PubSub register was used
+      activatePubSub();
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  void OpcUABackend::unsubscribePubSub([[maybe_unused]] OpcUABackendRegisterAccessorBase* accessor) {
+#ifdef UA_ENABLE_PUBSUB
+    if(_pubSubSubscriber) {
+      _pubSubSubscriber->unsubscribe(accessor);
+    }
+#endif
+  }
+
+  bool OpcUABackend::subscribePoll(OpcUABackendRegisterAccessorBase* accessor) {
+    if(!accessor->info->options.usesPolling()) {
+      return false;
+    }
+    if(!_pollScheduler) {
+      _pollScheduler = std::make_unique<OPCUAPollScheduler>(_connection);
+    }
+    _pollScheduler->subscribe(accessor);
+    if(_subscriptionManager && _subscriptionManager->isAsyncReadActive()) {
+      // async read was activated before the first polled register was used
+      _pollScheduler->activate();
+    }
+    return true;
+  }
+
+  void OpcUABackend::unsubscribePoll(OpcUABackendRegisterAccessorBase* accessor) {
+    if(_pollScheduler) {
+      _pollScheduler->unsubscribe(accessor);
     }
   }
 
   void OpcUABackend::setExceptionImpl() noexcept {
-    if(_subscriptionManager) {
-      _subscriptionManager->deactivateAllAndPushException();
+    for(auto& manager : {_subscriptionManager, _prioritySubscriptionManager}) {
+      if(manager) {
+        manager->deactivateAllAndPushException();
+      }
+    }
+    if(_pollScheduler) {
+      _pollScheduler->deactivate("Exception reported by another accessor.");
+    }
+#ifdef UA_ENABLE_PUBSUB
+    if(_pubSubSubscriber) {
+      _pubSubSubscriber->deactivate("Exception reported by another accessor.");
     }
+#endif
   }
 
   template<typename UserType>
@@ -618,6 +1149,11 @@ namespace ChimeraTK {
       throw ChimeraTK::logic_error(ss.str());
     }
 
+    if(info->isSubscriptionOnly() && !flags.has(AccessMode::wait_for_new_data)) {
+      throw ChimeraTK::logic_error(std::string("History and aggregate register ") + registerPathName +
+          " only supports AccessMode::wait_for_new_data.");
+    }
+
     if(numberOfWords == 0) {
       numberOfWords = info->arrayLength;
     }
@@ -671,6 +1207,11 @@ namespace ChimeraTK {
         return boost::make_shared<OpcUABackendRegisterAccessor<UA_String, UserType>>(
             path, shared_from_this(), registerPathName, info, flags, numberOfWords, wordOffsetInRegister);
         break;
+      case 15:
+        // the bytes of the ByteString are the elements of the register
+        return boost::make_shared<OpcUABackendRegisterAccessor<UA_Byte, UserType>>(
+            path, shared_from_this(), registerPathName, info, flags, numberOfWords, wordOffsetInRegister);
+        break;
       default:
         throw ChimeraTK::runtime_error(std::string("Type ") + std::to_string(info->dataType) + " not implemented.");
         break;
@@ -680,7 +1221,10 @@ namespace ChimeraTK {
   OpcUABackend::BackendRegisterer::BackendRegisterer() {
     BackendFactory::getInstance().registerBackendType("opcua", &OpcUABackend::createInstance,
         {"port", "username", "password", "map", "publishingInterval", "rootNode", "connectionTimeout", "certificate",
-            "privateKey", "cacheFile"});
+            "privateKey", "cacheFile", "publishRequests", "maxNotificationsPerPublish", "lifetimeCount",
+            "maxKeepAliveCount", "pubSubUrl", "pubSubInterface", "priorityPublishingInterval",
+            "priorityRealtime", "healthCheckInterval", "maxRoundTripTime",
+            "itemGracePeriod", "maxPooledItems", "registerNodes", "maxAge", "maxPendingWrites", "maxMessageSize"});
     std::cout << "BackendRegisterer: registered backend type opcua" << std::endl;
   }
 
@@ -742,6 +1286,70 @@ namespace ChimeraTK {
     UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Connection timeout is set to: %uld ms",
         connectionTimeout);
 
+    SubscriptionSettings subscriptionSettings;
+    if(!parameters["publishRequests"].empty()) {
+      auto publishRequests = std::stoul(parameters["publishRequests"]);
+      if(publishRequests > std::numeric_limits<UA_UInt16>::max()) {
+        throw ChimeraTK::logic_error("publishRequests must not exceed " +
+            std::to_string(std::numeric_limits<UA_UInt16>::max()) + ", but is " + parameters["publishRequests"] + ".");
+      }
+      subscriptionSettings.publishRequests = (UA_UInt16)publishRequests;
+    }
+    if(!parameters["maxNotificationsPerPublish"].empty()) {
+      subscriptionSettings.maxNotificationsPerPublish = std::stoul(parameters["maxNotificationsPerPublish"]);
+    }
+    if(!parameters["lifetimeCount"].empty()) {
+      subscriptionSettings.lifetimeCount = std::stoul(parameters["lifetimeCount"]);
+    }
+    if(!parameters["maxKeepAliveCount"].empty()) {
+      subscriptionSettings.maxKeepAliveCount = std::stoul(parameters["maxKeepAliveCount"]);
+    }
+    if(!parameters["itemGracePeriod"].empty()) {
+      subscriptionSettings.itemGracePeriod = std::stoul(parameters["itemGracePeriod"]);
+    }
+    if(!parameters["maxPooledItems"].empty()) {
+      subscriptionSettings.maxPooledItems = std::stoul(parameters["maxPooledItems"]);
+    }
+
+    PubSubSettings pubSubSettings{parameters["pubSubUrl"], parameters["pubSubInterface"]};
+
+    HealthMonitorSettings healthSettings;
+    if(!parameters["healthCheckInterval"].empty()) {
+      healthSettings.interval = std::stoul(parameters["healthCheckInterval"]);
+    }
+    if(!parameters["maxRoundTripTime"].empty()) {
+      healthSettings.maxRoundTripTime = std::stod(parameters["maxRoundTripTime"]);
+    }
+
+    PriorityLaneSettings prioritySettings;
+    if(!parameters["priorityPublishingInterval"].empty()) {
+      prioritySettings.publishingInterval = std::stod(parameters["priorityPublishingInterval"]);
+    }
+    if(!parameters["priorityRealtime"].empty()) {
+      prioritySettings.realtimePriority = std::stoi(parameters["priorityRealtime"]);
+    }
+
+    bool registerNodes = true;
+    if(!parameters["registerNodes"].empty()) {
+      auto testStr = boost::algorithm::to_upper_copy(parameters["registerNodes"]);
+      registerNodes = testStr == "1" || testStr == "TRUE" || testStr == "YES";
+    }
+
+    double maxAge = 0;
+    if(!parameters["maxAge"].empty()) {
+      maxAge = std::stod(parameters["maxAge"]);
+    }
+
+    size_t maxPendingWrites = 0;
+    if(!parameters["maxPendingWrites"].empty()) {
+      maxPendingWrites = std::stoul(parameters["maxPendingWrites"]);
+    }
+
+    uint32_t maxMessageSize = 0;
+    if(!parameters["maxMessageSize"].empty()) {
+      maxMessageSize = std::stoul(parameters["maxMessageSize"]);
+    }
+
     UA_LogLevel logLevel = UA_LOGLEVEL_INFO;
     if(!parameters["logLevel"].empty()) {
       std::transform(
@@ -774,6 +1382,7 @@ namespace ChimeraTK {
     return boost::shared_ptr<DeviceBackend>(new OpcUABackend(serverAddress, parameters["username"],
         parameters["password"], parameters["map"], publishingInterval, rootName, rootNS, connectionTimeout, logLevel,
         parameters["certificate"], parameters["privateKey"], trustAny, parameters["trustListFolder"],
-        parameters["revocationListFolder"], parameters["cacheFile"]));
+        parameters["revocationListFolder"], parameters["cacheFile"], subscriptionSettings, pubSubSettings,
+        prioritySettings, healthSettings, registerNodes, maxAge, maxPendingWrites, maxMessageSize));
   }
 } // namespace ChimeraTK
@@ -0,0 +1,208 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * PagedTransfer.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "PagedTransfer.h"
+
+#include "OPC-UA-Backend.h"
+
+#include <open62541/client.h>
+#include <open62541/client_highlevel_async.h>
+#include <open62541/plugin/log.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace ChimeraTK {
+
+  OPCUAPagedTransfer::OPCUAPagedTransfer(
+      OPCUAConnection& connection, const UA_NodeId& node, size_t start, size_t length, size_t pageSize)
+  : _connection(connection), _node(node), _start(start) {
+    pageSize = std::max<size_t>(pageSize, 1);
+    for(size_t offset = 0; offset < length; offset += pageSize) {
+      _pages.push_back({this, offset, std::min(pageSize, length - offset)});
+    }
+  }
+
+  size_t OPCUAPagedTransfer::getReadPageSize(const OPCUAConnection& connection, const UA_DataType* type) {
+    const UA_ConnectionConfig& limits = connection.config->localConnectionConfig;
+    return getPageSize(limits.localMaxMessageSize, limits.recvBufferSize, limits.localMaxChunkCount, type);
+  }
+
+  size_t OPCUAPagedTransfer::getWritePageSize(const OPCUAConnection& connection, const UA_DataType* type) {
+    const UA_ConnectionConfig& limits = connection.config->localConnectionConfig;
+    size_t messageSize = maxServerMessageSize;
+    if(limits.remoteMaxMessageSize > 0) {
+      messageSize = std::min<size_t>(messageSize, limits.remoteMaxMessageSize);
+    }
+    return getPageSize(messageSize, limits.sendBufferSize, limits.remoteMaxChunkCount, type);
+  }
+
+  size_t OPCUAPagedTransfer::getPageSize(
+      size_t maxMessageSize, size_t chunkSize, size_t maxChunkCount, const UA_DataType* type) {
+    if(!type->pointerFree) {
+      return 0;
+    }
+    size_t messageSize = std::numeric_limits<size_t>::max();
+    if(maxMessageSize > 0) {
+      messageSize = maxMessageSize;
+    }
+    if(maxChunkCount > 0) {
+      messageSize = std::min(messageSize, chunkSize * maxChunkCount);
+    }
+    if(messageSize == std::numeric_limits<size_t>::max()) {
+      return 0;
+    }
+    size_t payload = messageSize > 2 * messageOverhead ? messageSize - messageOverhead : messageSize / 2;
+    return std::max<size_t>(payload / type->memSize, 1);
+  }
+
+  UA_StatusCode OPCUAPagedTransfer::read(
+      double maxAge, const std::function<UA_StatusCode(size_t, const UA_DataValue&)>& onPage) {
+    _onPage = &onPage;
+    auto status = transfer([&](Page& page) {
+      std::string range = getRange(page);
+      UA_ReadValueId id;
+      UA_ReadValueId_init(&id);
+      id.nodeId = _node;
+      id.attributeId = UA_ATTRIBUTEID_VALUE;
+      id.indexRange = UA_STRING(range.data());
+      UA_ReadRequest request;
+      UA_ReadRequest_init(&request);
+      request.nodesToRead = &id;
+      request.nodesToReadSize = 1;
+      request.maxAge = maxAge;
+      request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+      // the request is encoded when sending, so node and range are only borrowed
+      return UA_Client_sendAsyncReadRequest(
+          _connection.client.get(), &request, &OPCUAPagedTransfer::readCallback, &page, nullptr);
+    });
+    _onPage = nullptr;
+    return status;
+  }
+
+  UA_StatusCode OPCUAPagedTransfer::write(
+      const UA_DataType* type, const std::function<void(size_t, size_t, void*)>& fillPage) {
+    return transfer([&](Page& page) {
+      void* array = UA_Array_new(page.count, type);
+      if(array == nullptr) {
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+      }
+      fillPage(page.offset, page.count, array);
+      std::string range = getRange(page);
+      UA_WriteValue writeValue;
+      UA_WriteValue_init(&writeValue);
+      writeValue.nodeId = _node;
+      writeValue.attributeId = UA_ATTRIBUTEID_VALUE;
+      writeValue.indexRange = UA_STRING(range.data());
+      writeValue.value.hasValue = true;
+      UA_Variant_setArray(&writeValue.value.value, array, page.count, type);
+      UA_WriteRequest request;
+      UA_WriteRequest_init(&request);
+      request.nodesToWrite = &writeValue;
+      request.nodesToWriteSize = 1;
+      UA_StatusCode ret = UA_Client_sendAsyncWriteRequest(
+          _connection.client.get(), &request, &OPCUAPagedTransfer::writeCallback, &page, nullptr);
+      // the page is encoded already - only one page at a time is kept in memory
+      UA_Array_delete(array, page.count, type);
+      return ret;
+    });
+  }
+
+  UA_StatusCode OPCUAPagedTransfer::transfer(const std::function<UA_StatusCode(Page&)>& send) {
+    auto timeout = std::chrono::milliseconds(_connection.connectionTimeout);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    size_t next = 0;
+    // after a failed page no more pages are sent, but the pages in flight are completed - aborting them would close
+    // the session used by all accessors of the connection
+    while((_status == UA_STATUSCODE_GOOD && next < _pages.size()) || _inFlight > 0) {
+      while(_status == UA_STATUSCODE_GOOD && next < _pages.size() && _inFlight < maxPagesInFlight) {
+        UA_StatusCode ret = send(_pages[next]);
+        if(ret != UA_STATUSCODE_GOOD) {
+          _status = ret;
+          break;
+        }
+        ++_inFlight;
+        ++next;
+      }
+      size_t inFlight = _inFlight;
+      UA_StatusCode ret = UA_Client_run_iterate(_connection.client.get(), 10);
+      if(ret != UA_STATUSCODE_GOOD) {
+        // the connection is broken, so the pages in flight are not completed any more
+        if(_status == UA_STATUSCODE_GOOD) {
+          _status = ret;
+        }
+        break;
+      }
+      auto now = std::chrono::steady_clock::now();
+      if(_inFlight < inFlight) {
+        // the timeout applies to each response, not to the whole transfer
+        deadline = now + timeout;
+      }
+      else if(now > deadline) {
+        if(_status == UA_STATUSCODE_GOOD) {
+          _status = UA_STATUSCODE_BADTIMEOUT;
+        }
+        break;
+      }
+    }
+    if(_inFlight > 0) {
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Aborting paged transfer with %zu pages in flight: %s", _inFlight, UA_StatusCode_name(_status));
+      // the callbacks refer to the pages, so the requests are aborted before the pages are destroyed - the accessor
+      // reports the returned status as exception, so the backend recovers the connection
+      _connection.close();
+    }
+    return _status;
+  }
+
+  std::string OPCUAPagedTransfer::getRange(const Page& page) const {
+    size_t first = _start + page.offset;
+    if(page.count == 1) {
+      return std::to_string(first);
+    }
+    return std::to_string(first) + ":" + std::to_string(first + page.count - 1);
+  }
+
+  void OPCUAPagedTransfer::readCallback(
+      UA_Client* /*client*/, void* userdata, UA_UInt32 /*requestId*/, UA_ReadResponse* response) {
+    auto* page = static_cast<Page*>(userdata);
+    UA_StatusCode status = response->responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD && response->resultsSize != 1) {
+      status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    if(status == UA_STATUSCODE_GOOD) {
+      const UA_DataValue& value = response->results[0];
+      status = value.hasStatus ? value.status : UA_STATUSCODE_GOOD;
+      if(status == UA_STATUSCODE_GOOD && !value.hasValue) {
+        status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+      }
+      if(status == UA_STATUSCODE_GOOD && page->transfer->_status == UA_STATUSCODE_GOOD) {
+        status = (*page->transfer->_onPage)(page->offset, value);
+      }
+    }
+    page->transfer->complete(status);
+  }
+
+  void OPCUAPagedTransfer::writeCallback(
+      UA_Client* /*client*/, void* userdata, UA_UInt32 /*requestId*/, UA_WriteResponse* response) {
+    auto* page = static_cast<Page*>(userdata);
+    UA_StatusCode status = response->responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD) {
+      status = response->resultsSize == 1 ? response->results[0] : UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    page->transfer->complete(status);
+  }
+
+  void OPCUAPagedTransfer::complete(UA_StatusCode status) {
+    --_inFlight;
+    if(status != UA_STATUSCODE_GOOD && _status == UA_STATUSCODE_GOOD) {
+      _status = status;
+    }
+  }
+} // namespace ChimeraTK
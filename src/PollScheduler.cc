@@ -0,0 +1,324 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * PollScheduler.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "PollScheduler.h"
+
+#include "OPC-UA-Backend.h"
+#include "OPC-UA-BackendRegisterAccessor.h"
+
+#include <ChimeraTK/Exception.h>
+
+#include <open62541/client.h>
+#include <open62541/plugin/log.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace ChimeraTK {
+
+  PollItem::PollItem(const OpcUABackendRegisterAccessorBase* accessor, UA_UInt32 interval)
+  : indexRange(accessor->info->indexRange), rangeStart(accessor->info->getRangeStart()), interval(interval),
+    maxAge(accessor->getMaxAge()), browseName(accessor->info->nodeBrowseName) {
+    UA_NodeId_copy(&accessor->info->id, &node);
+  }
+
+  PollItem::~PollItem() {
+    UA_NodeId_clear(&node);
+  }
+
+  void PollItem::push(const UA_DataValue* value, OpcUABackendRegisterAccessorBase* accessor) const {
+    if(!value->hasValue || UA_Variant_isScalar(&value->value) || accessor->needsFullNode()) {
+      accessor->notifications.push_overwrite(ManagedDataValue(value));
+      return;
+    }
+    size_t offset = accessor->windowStart - rangeStart;
+    if(offset == 0 && accessor->windowLength == value->value.arrayLength) {
+      accessor->notifications.push_overwrite(ManagedDataValue(value));
+      return;
+    }
+    accessor->notifications.push_overwrite(ManagedDataValue(value, offset, accessor->windowLength));
+  }
+
+  OPCUAPollScheduler::OPCUAPollScheduler(std::shared_ptr<OPCUAConnection> connection)
+  : _connection(std::move(connection)), _wheel(wheelSize) {}
+
+  OPCUAPollScheduler::~OPCUAPollScheduler() {
+    deactivate("");
+  }
+
+  void OPCUAPollScheduler::subscribe(OpcUABackendRegisterAccessorBase* accessor) {
+    auto ticks = static_cast<UA_UInt32>((accessor->info->options.pollInterval + tickInterval.count() - 1) /
+        tickInterval.count());
+    ticks = std::max<UA_UInt32>(ticks, 1);
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = std::find_if(_items.begin(), _items.end(), [&](const PollItem& item) {
+      return item.interval == ticks && item.indexRange == accessor->info->indexRange &&
+          UA_NodeId_equal(&item.node, &accessor->info->id);
+    });
+    if(it != _items.end()) {
+      it->accessors.push_back(accessor);
+      it->maxAge = std::min(it->maxAge, accessor->getMaxAge());
+      if(_run && it->lastValue.hasValue()) {
+        // values are only pushed on change, so the new accessor gets the current value here
+        it->push(it->lastValue.getDataValue(), accessor);
+      }
+      return;
+    }
+    auto& item = _items.emplace_back(accessor, ticks);
+    item.id = ++_lastItemId;
+    item.accessors.push_back(accessor);
+    UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Polling node %s every %u ticks.",
+        item.browseName.c_str(), ticks);
+    schedule(&item, 1);
+  }
+
+  void OPCUAPollScheduler::unsubscribe(OpcUABackendRegisterAccessorBase* accessor) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(auto it = _items.begin(); it != _items.end(); ++it) {
+      auto& accessors = it->accessors;
+      auto found = std::find(accessors.begin(), accessors.end(), accessor);
+      if(found == accessors.end()) {
+        continue;
+      }
+      accessors.erase(found);
+      if(accessors.empty()) {
+        unschedule(&(*it));
+        _items.erase(it);
+        ++_removals;
+      }
+      return;
+    }
+  }
+
+  void OPCUAPollScheduler::activate() {
+    if(_run) {
+      return;
+    }
+    // the thread might have stopped itself after a failed read
+    if(_thread && _thread->joinable()) {
+      _thread->join();
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      // all items are read in the first tick and the values are pushed, since the accessors expect an initial value
+      for(auto& slot : _wheel) {
+        slot.clear();
+      }
+      for(auto& item : _items) {
+        item.lastValue = ManagedDataValue();
+        schedule(&item, 1);
+      }
+      UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Start polling %zu items.", _items.size());
+    }
+    _run = true;
+    _thread = std::make_unique<std::thread>(&OPCUAPollScheduler::run, this);
+  }
+
+  void OPCUAPollScheduler::deactivate(const std::string& message) {
+    bool wasActive;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      wasActive = _run.exchange(false);
+    }
+    _stopCondition.notify_all();
+    if(_thread && _thread->joinable()) {
+      _thread->join();
+    }
+    _thread.reset();
+    if(wasActive && !message.empty()) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      pushException(message);
+    }
+  }
+
+  void OPCUAPollScheduler::schedule(PollItem* item, size_t ticks) {
+    ticks = std::max<size_t>(ticks, 1);
+    item->rounds = (ticks - 1) / wheelSize;
+    _wheel[(_currentSlot + ticks) % wheelSize].push_back(item);
+  }
+
+  void OPCUAPollScheduler::unschedule(PollItem* item) {
+    for(auto& slot : _wheel) {
+      slot.erase(std::remove(slot.begin(), slot.end(), item), slot.end());
+    }
+  }
+
+  void OPCUAPollScheduler::advance(std::vector<DueItem>& due) {
+    _currentSlot = (_currentSlot + 1) % wheelSize;
+    auto& slot = _wheel[_currentSlot];
+    std::vector<PollItem*> pending;
+    pending.swap(slot);
+    for(auto* item : pending) {
+      if(item->rounds > 0) {
+        --item->rounds;
+        slot.push_back(item);
+        continue;
+      }
+      due.emplace_back(item, item->id);
+      schedule(item, item->interval);
+    }
+  }
+
+  bool OPCUAPollScheduler::poll(const std::vector<DueItem>& items, size_t removals) {
+    // items reading the same node and range share an entry of the request
+    std::vector<PollItem*> due;
+    std::vector<size_t> dueIds;
+    std::vector<UA_ReadValueId> ids;
+    std::vector<size_t> index;
+    double maxAge = std::numeric_limits<double>::max();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      // items might be removed since they were taken from the wheel
+      for(const auto& [item, itemId] : items) {
+        if(_removals == removals || isKnown(item, itemId)) {
+          due.push_back(item);
+          dueIds.push_back(itemId);
+        }
+      }
+      removals = _removals;
+      index.resize(due.size());
+      for(size_t i = 0; i < due.size(); ++i) {
+        maxAge = std::min(maxAge, due[i]->maxAge);
+        auto same = std::find_if(due.begin(), due.begin() + i, [&](const PollItem* other) {
+          return other->readsSame(*due[i]);
+        });
+        if(same != due.begin() + i) {
+          index[i] = index[same - due.begin()];
+          continue;
+        }
+        UA_ReadValueId id;
+        UA_ReadValueId_init(&id);
+        // the node id is copied, since the item might be removed while reading
+        UA_NodeId_copy(&due[i]->node, &id.nodeId);
+        id.attributeId = UA_ATTRIBUTEID_VALUE;
+        if(!due[i]->indexRange.empty()) {
+          id.indexRange = UA_String_fromChars(due[i]->indexRange.c_str());
+        }
+        index[i] = ids.size();
+        ids.push_back(id);
+      }
+    }
+    if(ids.empty()) {
+      return true;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = ids.data();
+    request.nodesToReadSize = ids.size();
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    request.maxAge = maxAge;
+    UA_ReadResponse response;
+    {
+      std::lock_guard<std::mutex> lock(_connection->client_lock);
+      for(auto& id : ids) {
+        const UA_NodeId& alias = _connection->resolve(id.nodeId);
+        if(&alias != &id.nodeId) {
+          UA_NodeId node;
+          UA_NodeId_copy(&alias, &node);
+          UA_NodeId_clear(&id.nodeId);
+          id.nodeId = node;
+        }
+      }
+      response = UA_Client_Service_read(_connection->client.get(), request);
+    }
+    for(auto& id : ids) {
+      UA_ReadValueId_clear(&id);
+    }
+    UA_StatusCode status = response.responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD && response.resultsSize != ids.size()) {
+      status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(status != UA_STATUSCODE_GOOD) {
+      UA_ReadResponse_clear(&response);
+      if(_run) {
+        pushException(std::string("OPC-UA-Backend::Failed to poll ") + std::to_string(ids.size()) +
+            " nodes with reason: " + UA_StatusCode_name(status));
+      }
+      return false;
+    }
+    for(size_t i = 0; i < due.size(); ++i) {
+      auto* item = due[i];
+      // the item might be removed while reading
+      if(_removals != removals && !isKnown(item, dueIds[i])) {
+        continue;
+      }
+      UA_DataValue& value = response.results[index[i]];
+      const UA_DataValue* last = item->lastValue.getDataValue();
+      bool changed = last->hasValue != value.hasValue || last->status != value.status ||
+          (value.hasValue && UA_order(&last->value, &value.value, &UA_TYPES[UA_TYPES_VARIANT]) != UA_ORDER_EQ);
+      if(!changed) {
+        continue;
+      }
+      UA_DataValue copy;
+      UA_DataValue_copy(&value, &copy);
+      if(!copy.hasSourceTimestamp) {
+        // the version number is derived from the source time stamp
+        copy.hasSourceTimestamp = true;
+        copy.sourceTimestamp = UA_DateTime_now();
+      }
+      item->lastValue.moveFrom(&copy);
+      for(auto* accessor : item->accessors) {
+        item->push(item->lastValue.getDataValue(), accessor);
+      }
+    }
+    UA_ReadResponse_clear(&response);
+    return true;
+  }
+
+  bool OPCUAPollScheduler::isKnown(const PollItem* item, size_t id) const {
+    return std::any_of(_items.begin(), _items.end(),
+        [&](const PollItem& other) { return &other == item && other.id == id; });
+  }
+
+  void OPCUAPollScheduler::pushException(const std::string& message) {
+    UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Stop polling: %s", message.c_str());
+    for(auto& item : _items) {
+      for(auto* accessor : item.accessors) {
+        try {
+          throw ChimeraTK::runtime_error(message);
+        }
+        catch(...) {
+          accessor->notifications.push_overwrite_exception(std::current_exception());
+        }
+      }
+    }
+  }
+
+  void OPCUAPollScheduler::run() {
+    auto nextTick = std::chrono::steady_clock::now();
+    std::vector<DueItem> due;
+    size_t removals;
+    while(_run) {
+      due.clear();
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        nextTick += tickInterval;
+        _stopCondition.wait_until(lock, nextTick, [this] { return !_run; });
+        if(!_run) {
+          break;
+        }
+        // ticks missed because of a slow read are caught up, the due items are read with a single request
+        auto now = std::chrono::steady_clock::now();
+        advance(due);
+        while(nextTick + tickInterval <= now) {
+          nextTick += tickInterval;
+          advance(due);
+        }
+        removals = _removals;
+      }
+      // an item due several times in the caught up ticks is read once
+      std::sort(due.begin(), due.end());
+      due.erase(std::unique(due.begin(), due.end()), due.end());
+      if(!due.empty() && !poll(due, removals)) {
+        // the accessors got an exception - polling is started again when the device is recovered
+        _run = false;
+      }
+    }
+  }
+} // namespace ChimeraTK
@@ -0,0 +1,300 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * PubSubSubscriber.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "PubSubSubscriber.h"
+
+#ifdef UA_ENABLE_PUBSUB
+#  include "OPC-UA-Backend.h"
+#  include "OPC-UA-BackendRegisterAccessor.h"
+
+#  include <ChimeraTK/Exception.h>
+
+#  include <open62541/plugin/log.h>
+#  include <open62541/server_config_default.h>
+#  include <open62541/server_pubsub.h>
+
+#  include <algorithm>
+#  include <cstring>
+
+namespace ChimeraTK {
+
+  OPCUAPubSubSubscriber::OPCUAPubSubSubscriber(
+      const PubSubSettings& settings, const OpcUaBackendRegisterCatalogue& catalogue)
+  : _settings(settings) {
+    UA_NodeId_init(&_readerGroupId);
+    // collect the fields of all DataSets referenced in the catalogue
+    for(const auto& info : catalogue) {
+      if(!info.options.usesPubSub()) {
+        continue;
+      }
+      auto& fields = _dataSets[getKey(info.options)];
+      if(fields.size() <= info.options.dataSetField) {
+        fields.resize(info.options.dataSetField + 1);
+      }
+      auto& field = fields[info.options.dataSetField];
+      field.dataType = info.dataType;
+      field.arrayLength = info.arrayLength;
+    }
+  }
+
+  OPCUAPubSubSubscriber::~OPCUAPubSubSubscriber() {
+    _run = false;
+    if(_thread && _thread->joinable()) {
+      _thread->join();
+    }
+  }
+
+  PubSubField* OPCUAPubSubSubscriber::findField(const OpcUABackendRegisterOptions& options) {
+    auto dataSet = _dataSets.find(getKey(options));
+    if(dataSet == _dataSets.end() || dataSet->second.size() <= options.dataSetField) {
+      return nullptr;
+    }
+    return &dataSet->second[options.dataSetField];
+  }
+
+  void OPCUAPubSubSubscriber::subscribe(OpcUABackendRegisterAccessorBase* accessor) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto* field = findField(accessor->info->options);
+    if(field == nullptr) {
+      throw ChimeraTK::logic_error(std::string("OPC-UA-Backend::Register ") + accessor->info->nodeBrowseName +
+          " is mapped to a DataSet field that was not in the catalogue when the PubSub subscriber was created.");
+    }
+    field->accessors.push_back(accessor);
+  }
+
+  void OPCUAPubSubSubscriber::unsubscribe(OpcUABackendRegisterAccessorBase* accessor) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto* field = findField(accessor->info->options);
+    if(field == nullptr) {
+      return;
+    }
+    auto& accessors = field->accessors;
+    accessors.erase(std::remove(accessors.begin(), accessors.end(), accessor), accessors.end());
+  }
+
+  void OPCUAPubSubSubscriber::activate() {
+    if(_run) {
+      return;
+    }
+    if(!_server) {
+      try {
+        setupServer();
+      }
+      catch(ChimeraTK::runtime_error& e) {
+        pushException(e.what());
+        throw;
+      }
+    }
+    _run = true;
+    UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Receiving %zu DataSets from %s.",
+        _dataSets.size(), _settings.url.c_str());
+    _thread = std::make_unique<std::thread>(&OPCUAPubSubSubscriber::run, this);
+  }
+
+  void OPCUAPubSubSubscriber::deactivate(const std::string& message) {
+    bool wasActive = _run.exchange(false);
+    if(_thread && _thread->joinable()) {
+      _thread->join();
+      _thread.reset(nullptr);
+    }
+    if(wasActive && !message.empty()) {
+      pushException(message);
+    }
+  }
+
+  void OPCUAPubSubSubscriber::pushException(const std::string& message) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(auto& dataSet : _dataSets) {
+      for(auto& field : dataSet.second) {
+        for(auto* accessor : field.accessors) {
+          try {
+            throw ChimeraTK::runtime_error(message);
+          }
+          catch(...) {
+            accessor->notifications.push_overwrite_exception(std::current_exception());
+          }
+        }
+      }
+    }
+  }
+
+  void OPCUAPubSubSubscriber::setupServer() {
+    // the local server is only used to receive DataSets - the OS chooses a free port for its unused endpoint
+    auto config = UA_ServerConfig();
+    config.logging = &OpcUABackend::backendLogger;
+    UA_ServerConfig_setMinimal(&config, 0, nullptr);
+    _server.reset(UA_Server_newWithConfig(&config));
+    if(!_server) {
+      throw ChimeraTK::runtime_error("Failed to create the server used for PubSub.");
+    }
+
+    UA_PubSubConnectionConfig connectionConfig;
+    memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+    connectionConfig.name = UA_STRING(const_cast<char*>("ChimeraTK PubSub subscriber"));
+    connectionConfig.transportProfileUri =
+        UA_STRING(const_cast<char*>("http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp"));
+    UA_NetworkAddressUrlDataType address{
+        UA_STRING(_settings.networkInterface.data()), UA_STRING(_settings.url.data())};
+    UA_Variant_setScalar(&connectionConfig.address, &address, &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+    connectionConfig.publisherId.idType = UA_PUBLISHERIDTYPE_UINT32;
+    connectionConfig.publisherId.id.uint32 = UA_UInt32_random();
+    UA_NodeId connectionId;
+    UA_StatusCode ret = UA_Server_addPubSubConnection(_server.get(), &connectionConfig, &connectionId);
+    if(ret != UA_STATUSCODE_GOOD) {
+      _server.reset();
+      throw ChimeraTK::runtime_error(std::string("Failed to create PubSub connection for ") + _settings.url +
+          ". Error: " + UA_StatusCode_name(ret));
+    }
+
+    UA_ReaderGroupConfig readerGroupConfig;
+    memset(&readerGroupConfig, 0, sizeof(UA_ReaderGroupConfig));
+    readerGroupConfig.name = UA_STRING(const_cast<char*>("ChimeraTK reader group"));
+    ret = UA_Server_addReaderGroup(_server.get(), connectionId, &readerGroupConfig, &_readerGroupId);
+    if(ret != UA_STATUSCODE_GOOD) {
+      _server.reset();
+      throw ChimeraTK::runtime_error(std::string("Failed to create PubSub reader group. Error: ") +
+          UA_StatusCode_name(ret));
+    }
+
+    for(auto& [key, fields] : _dataSets) {
+      addReader(key, fields);
+    }
+    UA_Server_enableAllPubSubComponents(_server.get());
+  }
+
+  void OPCUAPubSubSubscriber::addReader(const DataSetKey& key, std::vector<PubSubField>& fields) {
+    auto [publisherId, writerGroupId, dataSetWriterId] = key;
+    std::string readerName = "DataSetReader " + std::to_string(publisherId) + "/" + std::to_string(writerGroupId) +
+        "/" + std::to_string(dataSetWriterId);
+
+    // fields not mapped in the catalogue accept any data type
+    std::vector<std::string> fieldNames(fields.size());
+    std::vector<UA_FieldMetaData> metaData(fields.size());
+    for(size_t i = 0; i < fields.size(); ++i) {
+      fieldNames[i] = readerName + " field " + std::to_string(i);
+      UA_FieldMetaData_init(&metaData[i]);
+      metaData[i].name = UA_STRING(fieldNames[i].data());
+      if(fields[i].dataType != 0) {
+        metaData[i].dataType = UA_NODEID_NUMERIC(0, fields[i].dataType);
+        metaData[i].builtInType = static_cast<UA_Byte>(fields[i].dataType);
+        metaData[i].valueRank = fields[i].arrayLength > 1 ? UA_VALUERANK_ONE_DIMENSION : UA_VALUERANK_SCALAR;
+      }
+      else {
+        metaData[i].dataType = UA_NS0ID(BASEDATATYPE);
+        metaData[i].builtInType = UA_NS0ID_BASEDATATYPE;
+        metaData[i].valueRank = UA_VALUERANK_ANY;
+      }
+    }
+
+    UA_DataSetReaderConfig readerConfig;
+    memset(&readerConfig, 0, sizeof(UA_DataSetReaderConfig));
+    readerConfig.name = UA_STRING(readerName.data());
+    readerConfig.publisherId.idType = UA_PUBLISHERIDTYPE_UINT16;
+    readerConfig.publisherId.id.uint16 = publisherId;
+    readerConfig.writerGroupId = writerGroupId;
+    readerConfig.dataSetWriterId = dataSetWriterId;
+    // the meta data is only borrowed - it is copied by the server
+    readerConfig.dataSetMetaData.fieldsSize = metaData.size();
+    readerConfig.dataSetMetaData.fields = metaData.data();
+    UA_NodeId readerId;
+    UA_StatusCode ret = UA_Server_addDataSetReader(_server.get(), _readerGroupId, &readerConfig, &readerId);
+    if(ret != UA_STATUSCODE_GOOD) {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Failed to add %s. Error: %s",
+          readerName.c_str(), UA_StatusCode_name(ret));
+      return;
+    }
+    // remove the reader and the target variables added so far, so no half configured reader is left in the server
+    size_t nTargets = 0;
+    auto removeReader = [&] {
+      for(size_t i = 0; i < fields.size(); ++i) {
+        if(i < nTargets) {
+          UA_Server_deleteNode(_server.get(), fields[i].targetNode, true);
+        }
+        UA_NodeId_init(&fields[i].targetNode);
+        fields[i].subscriber = nullptr;
+      }
+      UA_Server_removeDataSetReader(_server.get(), readerId);
+    };
+
+    // the reader writes the fields to variables of the local server, whose write callback pushes the values
+    std::vector<UA_FieldTargetDataType> targets(fields.size());
+    for(size_t i = 0; i < fields.size(); ++i) {
+      UA_VariableAttributes attr = UA_VariableAttributes_default;
+      attr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>("en_US"), fieldNames[i].data());
+      attr.dataType = metaData[i].dataType;
+      attr.valueRank = metaData[i].valueRank;
+      attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+      fields[i].subscriber = this;
+      ret = UA_Server_addVariableNode(_server.get(), UA_NODEID_NULL, UA_NS0ID(OBJECTSFOLDER), UA_NS0ID(HASCOMPONENT),
+          UA_QUALIFIEDNAME(1, fieldNames[i].data()), UA_NS0ID(BASEDATAVARIABLETYPE), attr, &fields[i],
+          &fields[i].targetNode);
+      if(ret != UA_STATUSCODE_GOOD) {
+        UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Failed to add target variable for %s.",
+            fieldNames[i].c_str());
+        removeReader();
+        return;
+      }
+      ++nTargets;
+      UA_ValueCallback callback{nullptr, &OPCUAPubSubSubscriber::onWrite};
+      UA_Server_setVariableNode_valueCallback(_server.get(), fields[i].targetNode, callback);
+      UA_FieldTargetDataType_init(&targets[i]);
+      targets[i].attributeId = UA_ATTRIBUTEID_VALUE;
+      targets[i].targetNodeId = fields[i].targetNode;
+    }
+    ret = UA_Server_DataSetReader_createTargetVariables(_server.get(), readerId, targets.size(), targets.data());
+    if(ret != UA_STATUSCODE_GOOD) {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed to add target variables for %s. Error: %s", readerName.c_str(), UA_StatusCode_name(ret));
+      removeReader();
+      return;
+    }
+    UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Added %s with %zu fields.",
+        readerName.c_str(), fields.size());
+  }
+
+  void OPCUAPubSubSubscriber::run() {
+    UA_Server_run_startup(_server.get());
+    while(_run) {
+      UA_Server_run_iterate(_server.get(), true);
+    }
+    UA_Server_run_shutdown(_server.get());
+    UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Stopped receiving DataSets from %s.",
+        _settings.url.c_str());
+  }
+
+  void OPCUAPubSubSubscriber::onWrite(UA_Server* /*server*/, const UA_NodeId* /*sessionId*/,
+      void* /*sessionContext*/, const UA_NodeId* /*nodeId*/, void* nodeContext, const UA_NumericRange* /*range*/,
+      const UA_DataValue* data) {
+    auto* field = static_cast<PubSubField*>(nodeContext);
+    if(field == nullptr || field->subscriber == nullptr || !field->subscriber->_run) {
+      return;
+    }
+    UA_DataValue value;
+    UA_DataValue_init(&value);
+    if(UA_DataValue_copy(data, &value) != UA_STATUSCODE_GOOD) {
+      return;
+    }
+    if(!value.hasSourceTimestamp) {
+      // the version number is derived from the source time stamp
+      value.hasSourceTimestamp = true;
+      value.sourceTimestamp = UA_DateTime_now();
+    }
+    std::lock_guard<std::mutex> lock(field->subscriber->_mutex);
+    for(auto* accessor : field->accessors) {
+      if(!value.hasValue || UA_Variant_isScalar(&value.value) || accessor->needsFullNode()) {
+        accessor->notifications.push_overwrite(ManagedDataValue(&value));
+      }
+      else {
+        accessor->notifications.push_overwrite(ManagedDataValue(&value, accessor->windowStart, accessor->windowLength));
+      }
+    }
+    UA_DataValue_clear(&value);
+  }
+
+} // namespace ChimeraTK
+#endif
@@ -9,21 +9,110 @@
 
 #include "RegisterInfo.h"
 
+#include <stdexcept>
 #include <string>
 
 namespace ChimeraTK {
+  std::string toString(const OpcUAAggregateType& type) {
+    switch(type) {
+      case OpcUAAggregateType::min:
+        return "min";
+      case OpcUAAggregateType::max:
+        return "max";
+      case OpcUAAggregateType::mean:
+        return "mean";
+      case OpcUAAggregateType::last:
+        return "last";
+      case OpcUAAggregateType::count:
+        return "count";
+      default:
+        return "none";
+    }
+  }
+
+  OpcUAAggregateType aggregateFromString(const std::string& name) {
+    for(auto type : {OpcUAAggregateType::none, OpcUAAggregateType::min, OpcUAAggregateType::max,
+            OpcUAAggregateType::mean, OpcUAAggregateType::last, OpcUAAggregateType::count}) {
+      if(toString(type) == name) {
+        return type;
+      }
+    }
+    throw std::invalid_argument("Unknown aggregate: " + name);
+  }
+
+  size_t OpcUABackendRegisterInfo::getRangeStart() const {
+    if(indexRange.empty()) {
+      return 0;
+    }
+    auto range = UA_NUMERICRANGE(indexRange.c_str());
+    size_t start = range.dimensionsSize > 0 ? range.dimensions[0].min : 0;
+    UA_free(range.dimensions);
+    return start;
+  }
+
   void OpcUaBackendRegisterCatalogue::addProperty(const UA_NodeId& node, const std::string& browseName,
       const std::string& range, const UA_UInt32& dataType, const size_t& arrayLength, const std::string& serverAddress,
-      const std::string& description, const bool& isReadonly) {
+      const std::string& description, const bool& isReadonly, const OpcUABackendRegisterOptions& options,
+      const OpcUAHistoryContent& history, const size_t& numberOfChannels) {
     //    OpcUABackendRegisterInfo entry{serverAddress, browseName};
     //    UA_NodeId_copy(&node, &entry._id);
     OpcUABackendRegisterInfo entry{serverAddress, browseName, node};
     entry.dataType = dataType;
     entry.description = description;
     entry.arrayLength = arrayLength;
+    entry.numberOfChannels = std::max<size_t>(numberOfChannels, 1);
+    entry.isMultiDimensional = numberOfChannels > 0;
     entry.isReadonly = isReadonly;
     entry.accessModes.add(AccessMode::wait_for_new_data);
     entry.indexRange = range;
+    entry.options = options;
+    entry.historyContent = history;
+    if(setDataDescriptor(entry)) {
+      addRegister(entry);
+    }
+  }
+
+  void OpcUaBackendRegisterCatalogue::addStructureField(const UA_NodeId& node, const std::string& browseName,
+      const UA_UInt32& dataType, const std::string& serverAddress, const std::string& description,
+      const OpcUABackendRegisterOptions& options, const std::string& structureType, const size_t& structureField,
+      const std::shared_ptr<const OPCUAStructureType>& structure) {
+    OpcUABackendRegisterInfo entry{serverAddress, browseName, node};
+    entry.dataType = dataType;
+    entry.description = description;
+    entry.arrayLength = 1;
+    entry.isReadonly = true;
+    entry.accessModes.add(AccessMode::wait_for_new_data);
+    entry.options = options;
+    entry.structureType = structureType;
+    entry.structureField = structureField;
+    entry.structure = structure;
+    if(setDataDescriptor(entry)) {
+      addRegister(entry);
+    }
+  }
+
+  void OpcUaBackendRegisterCatalogue::addChannelGroup(const std::vector<UA_NodeId>& nodes,
+      const std::string& browseName, const UA_UInt32& dataType, const size_t& arrayLength,
+      const std::string& serverAddress, const std::string& description, const bool& isReadonly,
+      const OpcUABackendRegisterOptions& options) {
+    OpcUABackendRegisterInfo entry{serverAddress, browseName, nodes.front()};
+    entry.dataType = dataType;
+    entry.description = description;
+    entry.arrayLength = arrayLength;
+    entry.numberOfChannels = nodes.size();
+    entry.isReadonly = isReadonly;
+    entry.accessModes.add(AccessMode::wait_for_new_data);
+    entry.options = options;
+    entry.channelIds.resize(nodes.size());
+    for(size_t i = 0; i < nodes.size(); ++i) {
+      UA_NodeId_copy(&nodes[i], &entry.channelIds[i]);
+    }
+    if(setDataDescriptor(entry)) {
+      addRegister(entry);
+    }
+  }
+
+  bool OpcUaBackendRegisterCatalogue::setDataDescriptor(OpcUABackendRegisterInfo& entry) {
     // Maximum number of decimal digits to display a float without loss in non-exponential display, including
     // sign, leading 0, decimal dot and one extra digit to avoid rounding issues (hence the +4).
     // This computation matches the one performed in the NumericAddressedBackend catalogue.
@@ -38,7 +127,8 @@ namespace ChimeraTK {
       case 2: /*SByte aka int8*/
         entry.dataDescriptor = DataDescriptor(DataDescriptor::FundamentalType::numeric, true, true, 4, 300);
         break;
-      case 3: /*BYTE aka uint8*/
+      case 3:  /*BYTE aka uint8*/
+      case 15: /*ByteString - the bytes are the elements*/
         entry.dataDescriptor = DataDescriptor(DataDescriptor::FundamentalType::numeric, true, false, 3, 300);
         break;
       case 4: /*Int16*/
@@ -70,8 +160,8 @@ namespace ChimeraTK {
         entry.dataDescriptor = DataDescriptor(DataDescriptor::FundamentalType::string, true, true, 320, 300);
         break;
       default:
-        return;
+        return false;
     }
-    addRegister(entry);
+    return true;
   }
 } // namespace ChimeraTK
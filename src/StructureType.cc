@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+/*
+ * StructureType.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "StructureType.h"
+
+#include <ChimeraTK/Exception.h>
+
+#include <open62541/client.h>
+#include <open62541/types.h>
+
+#include <algorithm>
+
+namespace ChimeraTK {
+
+  OPCUAStructureType::OPCUAStructureType(const UA_NodeId& typeId, const UA_StructureDefinition& definition) {
+    if(definition.structureType != UA_STRUCTURETYPE_STRUCTURE || definition.fieldsSize == 0 ||
+        definition.fieldsSize > 255) {
+      throw ChimeraTK::runtime_error("Only structures without optional fields and with 1 to 255 fields are supported.");
+    }
+    size_t end = 0; // end of the previous member
+    for(size_t i = 0; i < definition.fieldsSize; ++i) {
+      const UA_StructureField& field = definition.fields[i];
+      std::string name((char*)field.name.data, field.name.length);
+      const UA_DataType* type = UA_findDataType(&field.dataType);
+      if(type == nullptr || field.isOptional || (field.valueRank != -1 && field.valueRank != 1) ||
+          (type->typeKind > UA_DATATYPEKIND_DIAGNOSTICINFO && type->typeKind != UA_DATATYPEKIND_ENUM)) {
+        throw ChimeraTK::runtime_error(
+            "Field " + name + " is optional, has more than one dimension or no built-in type.");
+      }
+      bool isArray = field.valueRank == 1;
+      // arrays are stored as length followed by the pointer to the elements
+      size_t size = isArray ? sizeof(size_t) + sizeof(void*) : type->memSize;
+      size_t alignment = std::min(size, sizeof(void*));
+      size_t offset = (end + alignment - 1) / alignment * alignment;
+      UA_DataTypeMember member{};
+      member.memberType = type;
+      member.padding = offset - end;
+      member.isArray = isArray;
+      member.isOptional = false;
+      _members.push_back(member);
+      _fields.push_back({name, type, offset, isArray});
+      end = offset + size;
+    }
+    UA_NodeId_copy(&typeId, &_type.typeId);
+    UA_NodeId_copy(&definition.defaultEncodingId, &_type.binaryEncodingId);
+    _type.memSize = (end + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+    _type.typeKind = UA_DATATYPEKIND_STRUCTURE;
+    _type.pointerFree = std::all_of(_fields.begin(), _fields.end(),
+        [](const Field& field) { return !field.isArray && field.type->pointerFree; });
+    _type.overlayable = false;
+    _type.membersSize = _members.size();
+    _type.members = _members.data();
+  }
+
+  OPCUAStructureType::~OPCUAStructureType() {
+    UA_NodeId_clear(&_type.typeId);
+    UA_NodeId_clear(&_type.binaryEncodingId);
+  }
+
+  std::shared_ptr<OPCUAStructureType> OPCUAStructureType::read(OPCUAConnection& connection, const UA_NodeId& typeId) {
+    UA_ReadValueId id;
+    UA_ReadValueId_init(&id);
+    id.nodeId = typeId;
+    id.attributeId = UA_ATTRIBUTEID_DATATYPEDEFINITION;
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = &id;
+    request.nodesToReadSize = 1;
+    UA_ReadResponse response = UA_Client_Service_read(connection.client.get(), request);
+    UA_StatusCode status = response.responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD && response.resultsSize != 1) {
+      status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    if(status == UA_STATUSCODE_GOOD && response.results[0].hasStatus) {
+      status = response.results[0].status;
+    }
+    if(status == UA_STATUSCODE_GOOD && response.results[0].value.type != &UA_TYPES[UA_TYPES_STRUCTUREDEFINITION]) {
+      status = UA_STATUSCODE_BADDATATYPEIDUNKNOWN;
+    }
+    if(status != UA_STATUSCODE_GOOD) {
+      UA_ReadResponse_clear(&response);
+      throw ChimeraTK::runtime_error(
+          std::string("Failed to read the structure definition with reason: ") + UA_StatusCode_name(status));
+    }
+    try {
+      auto type = std::make_shared<OPCUAStructureType>(
+          typeId, *static_cast<UA_StructureDefinition*>(response.results[0].value.data));
+      UA_ReadResponse_clear(&response);
+      return type;
+    }
+    catch(ChimeraTK::runtime_error&) {
+      UA_ReadResponse_clear(&response);
+      throw;
+    }
+  }
+
+  UA_StatusCode OPCUAStructureType::decode(UA_Variant& variant) const {
+    if(variant.type == &_type) {
+      return UA_STATUSCODE_GOOD;
+    }
+    if(variant.type != &UA_TYPES[UA_TYPES_EXTENSIONOBJECT] || !UA_Variant_isScalar(&variant)) {
+      return UA_STATUSCODE_BADTYPEMISMATCH;
+    }
+    auto* object = static_cast<UA_ExtensionObject*>(variant.data);
+    if(object->encoding != UA_EXTENSIONOBJECT_ENCODED_BYTESTRING ||
+        !UA_NodeId_equal(&object->content.encoded.typeId, &_type.binaryEncodingId)) {
+      return UA_STATUSCODE_BADTYPEMISMATCH;
+    }
+    void* structure = UA_new(&_type);
+    if(structure == nullptr) {
+      return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    UA_StatusCode ret = UA_decodeBinary(&object->content.encoded.body, structure, &_type, nullptr);
+    if(ret != UA_STATUSCODE_GOOD) {
+      UA_delete(structure, &_type);
+      return ret;
+    }
+    UA_Variant_clear(&variant);
+    UA_Variant_setScalar(&variant, structure, &_type);
+    return UA_STATUSCODE_GOOD;
+  }
+
+  const void* OPCUAStructureType::getField(const UA_Variant& variant, size_t field) const {
+    if(variant.type != &_type || variant.data == nullptr || field >= _fields.size()) {
+      return nullptr;
+    }
+    return static_cast<const char*>(variant.data) + _fields[field].offset;
+  }
+} // namespace ChimeraTK
@@ -17,13 +17,436 @@
 #include <open62541/client.h>
 #include <open62541/client_subscriptions.h>
 #include <open62541/plugin/log.h>
+#include <pthread.h>
+#include <sched.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <memory>
 
 namespace ChimeraTK {
 
+  namespace {
+    /**
+     * Get element i of the given variant as double. Returns false if the data type is not numeric.
+     */
+    bool elementToDouble(const UA_Variant& var, size_t i, double& result) {
+      const void* element = static_cast<const char*>(var.data) + i * var.type->memSize;
+      switch(var.type->typeKind) {
+        case UA_DATATYPEKIND_BOOLEAN:
+          result = *static_cast<const UA_Boolean*>(element) ? 1. : 0.;
+          return true;
+        case UA_DATATYPEKIND_SBYTE:
+          result = *static_cast<const UA_SByte*>(element);
+          return true;
+        case UA_DATATYPEKIND_BYTE:
+          result = *static_cast<const UA_Byte*>(element);
+          return true;
+        case UA_DATATYPEKIND_INT16:
+          result = *static_cast<const UA_Int16*>(element);
+          return true;
+        case UA_DATATYPEKIND_UINT16:
+          result = *static_cast<const UA_UInt16*>(element);
+          return true;
+        case UA_DATATYPEKIND_INT32:
+          result = *static_cast<const UA_Int32*>(element);
+          return true;
+        case UA_DATATYPEKIND_UINT32:
+          result = *static_cast<const UA_UInt32*>(element);
+          return true;
+        case UA_DATATYPEKIND_INT64:
+          result = static_cast<double>(*static_cast<const UA_Int64*>(element));
+          return true;
+        case UA_DATATYPEKIND_UINT64:
+          result = static_cast<double>(*static_cast<const UA_UInt64*>(element));
+          return true;
+        case UA_DATATYPEKIND_FLOAT:
+          result = *static_cast<const UA_Float*>(element);
+          return true;
+        case UA_DATATYPEKIND_DOUBLE:
+          result = *static_cast<const UA_Double*>(element);
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    /**
+     * Number of elements of the given variant. Scalars have one element.
+     */
+    size_t numberOfElements(const UA_Variant& var) {
+      return UA_Variant_isScalar(&var) ? 1 : var.arrayLength;
+    }
+
+    /**
+     * Store the given values in target. Counts are stored as UInt32 all other aggregates as Double, like announced in
+     * the catalogue. The time stamps are taken from reference.
+     */
+    void setAggregateValue(ManagedDataValue& target, const std::vector<double>& values, bool isScalar, bool isCount,
+        const UA_DataValue* reference) {
+      const UA_DataType* type = isCount ? &UA_TYPES[UA_TYPES_UINT32] : &UA_TYPES[UA_TYPES_DOUBLE];
+      void* array = UA_Array_new(values.size(), type);
+      if(array == nullptr) {
+        return;
+      }
+      for(size_t i = 0; i < values.size(); ++i) {
+        if(isCount) {
+          static_cast<UA_UInt32*>(array)[i] = static_cast<UA_UInt32>(std::lround(values[i]));
+        }
+        else {
+          static_cast<UA_Double*>(array)[i] = values[i];
+        }
+      }
+      UA_DataValue value;
+      UA_DataValue_init(&value);
+      if(isScalar) {
+        UA_Variant_setScalar(&value.value, array, type);
+      }
+      else {
+        UA_Variant_setArray(&value.value, array, values.size(), type);
+      }
+      value.hasValue = true;
+      value.hasStatus = reference->hasStatus;
+      value.status = reference->status;
+      value.hasSourceTimestamp = reference->hasSourceTimestamp;
+      value.sourceTimestamp = reference->sourceTimestamp;
+      value.hasServerTimestamp = reference->hasServerTimestamp;
+      value.serverTimestamp = reference->serverTimestamp;
+      target.moveFrom(&value);
+    }
+
+    /**
+     * Aggregate functions defined in OPC UA Part 13 used for the aggregates of the map file.
+     */
+    UA_NodeId aggregateFunction(const OpcUAAggregateType& type) {
+      switch(type) {
+        case OpcUAAggregateType::min:
+          return UA_NS0ID(AGGREGATEFUNCTION_MINIMUM);
+        case OpcUAAggregateType::max:
+          return UA_NS0ID(AGGREGATEFUNCTION_MAXIMUM);
+        case OpcUAAggregateType::mean:
+          return UA_NS0ID(AGGREGATEFUNCTION_AVERAGE);
+        case OpcUAAggregateType::count:
+          return UA_NS0ID(AGGREGATEFUNCTION_COUNT);
+        default:
+          return UA_NS0ID(AGGREGATEFUNCTION_END);
+      }
+    }
+
+    /**
+     * True if the status returned when creating a monitored item indicates that the requested AggregateFilter is not
+     * supported by the server.
+     */
+    bool isFilterError(UA_StatusCode status) {
+      return status == UA_STATUSCODE_BADMONITOREDITEMFILTERUNSUPPORTED ||
+          status == UA_STATUSCODE_BADMONITOREDITEMFILTERINVALID || status == UA_STATUSCODE_BADFILTERNOTALLOWED ||
+          status == UA_STATUSCODE_BADAGGREGATENOTSUPPORTED || status == UA_STATUSCODE_BADAGGREGATELISTMISMATCH ||
+          status == UA_STATUSCODE_BADAGGREGATEINVALIDINPUTS || status == UA_STATUSCODE_BADSERVICEUNSUPPORTED;
+    }
+  } // namespace
+
+  MonitorItem::MonitorItem(
+      const std::string& browseName, const UA_NodeId& node, OpcUABackendRegisterAccessorBase* accessor)
+  : node(node), channels(accessor->info->channelIds), browseName(browseName) {
+    accessors.push_back(accessor);
+    aggregate.settings = accessor->info->options;
+    // the server can only aggregate over time windows
+    aggregate.onServer = isAggregate() && aggregate.settings.aggregateSamples == 0;
+    updateRange();
+  }
+
+  bool MonitorItem::updateRange() {
+    std::string newRange;
+    size_t start = std::numeric_limits<size_t>::max();
+    size_t end = 0;
+    size_t newChunkSize = 0;
+    size_t newQueueSize = 1;
+    bool fullNode = false;
+    for(auto* accessor : accessors) {
+      auto accessorChunkSize = accessor->info->options.chunkSize;
+      if(accessorChunkSize != 0 && (newChunkSize == 0 || accessorChunkSize < newChunkSize)) {
+        newChunkSize = accessorChunkSize;
+      }
+      if(accessor->isHistory()) {
+        newQueueSize = std::max(newQueueSize, accessor->info->arrayLength);
+      }
+      if(fullNode) {
+        continue;
+      }
+      if(accessor->info->isChannelGroup()) {
+        // all accessors of the item belong to the same group and need all of its nodes
+        fullNode = true;
+        start = 0;
+        end = accessor->info->arrayLength * accessor->info->numberOfChannels;
+        newRange.clear();
+        continue;
+      }
+      if(accessor->isHistory() || accessor->needsFullNode()) {
+        // accessor needs the whole node - history registers are only created for scalar nodes
+        fullNode = true;
+        start = 0;
+        end = accessor->isHistory() ? 1 : accessor->info->arrayLength;
+        newRange.clear();
+        continue;
+      }
+      start = std::min(start, accessor->windowStart);
+      end = std::max(end, accessor->windowStart + accessor->windowLength);
+      newRange = end - start == 1 ? std::to_string(start) : std::to_string(start) + ":" + std::to_string(end - 1);
+    }
+    bool changed = newRange != indexRange || newChunkSize != chunkSize || newQueueSize != queueSize;
+    if(changed) {
+      // the last value refers to the old range
+      lastValue = ManagedDataValue();
+    }
+    indexRange = newRange;
+    rangeStart = start;
+    rangeLength = end - start;
+    chunkSize = newChunkSize;
+    queueSize = newQueueSize;
+    while(history.size() > queueSize) {
+      history.pop_front();
+    }
+    return changed;
+  }
+
+  bool MonitorItem::covers(const OpcUABackendRegisterAccessorBase* accessor) const {
+    if(indexRange.empty()) {
+      // the whole node is monitored
+      return true;
+    }
+    if(accessor->isHistory() || accessor->needsFullNode()) {
+      return false;
+    }
+    return accessor->windowStart >= rangeStart &&
+        accessor->windowStart + accessor->windowLength <= rangeStart + rangeLength;
+  }
+
+  void MonitorItem::createChunks() {
+    chunks.clear();
+    chunksReceived = 0;
+    pending = false;
+    aggregate.count = 0;
+    if(!channels.empty()) {
+      size_t channelLength = rangeLength / channels.size();
+      for(size_t i = 0; i < channels.size(); ++i) {
+        chunks.push_back({i * channelLength, channelLength});
+      }
+      return;
+    }
+    if(chunkSize == 0 || rangeLength <= chunkSize || isAggregate()) {
+      chunks.push_back({0, rangeLength});
+      return;
+    }
+    for(size_t start = 0; start < rangeLength; start += chunkSize) {
+      chunks.push_back({start, std::min(chunkSize, rangeLength - start)});
+    }
+  }
+
+  std::vector<UA_UInt32> MonitorItem::getMonitoredIds() const {
+    std::vector<UA_UInt32> ids;
+    for(const auto& chunk : chunks) {
+      if(chunk.id != 0) {
+        ids.push_back(chunk.id);
+      }
+    }
+    return ids;
+  }
+
+  void MonitorItem::updateChunk(size_t chunk, const UA_DataValue* value) {
+    UA_StatusCode ret = lastValue.setRange(value, chunks.at(chunk).start, rangeLength);
+    if(ret != UA_STATUSCODE_GOOD) {
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Failed to update chunk %zu of %s: %s",
+          chunk, browseName.c_str(), UA_StatusCode_name(ret));
+      return;
+    }
+    if(!chunks[chunk].received) {
+      chunks[chunk].received = true;
+      ++chunksReceived;
+    }
+    pending = true;
+  }
+
+  void MonitorItem::appendHistory() {
+    UA_DataValue sample;
+    UA_DataValue_init(&sample);
+    if(UA_DataValue_copy(lastValue.getDataValue(), &sample) != UA_STATUSCODE_GOOD) {
+      return;
+    }
+    history.emplace_back();
+    history.back().moveFrom(&sample);
+    while(history.size() > queueSize) {
+      history.pop_front();
+    }
+    pending = true;
+  }
+
+  void MonitorItem::addSample(const UA_DataValue* value) {
+    const UA_Variant& var = value->value;
+    size_t n = numberOfElements(var);
+    if(aggregate.count == 0 || n != aggregate.sum.size()) {
+      // start a new window
+      aggregate.count = 0;
+      aggregate.min.assign(n, std::numeric_limits<double>::max());
+      aggregate.max.assign(n, std::numeric_limits<double>::lowest());
+      aggregate.sum.assign(n, 0.);
+      aggregate.windowStart = std::chrono::steady_clock::now();
+    }
+    if(aggregate.settings.aggregate != OpcUAAggregateType::last) {
+      for(size_t i = 0; i < n; ++i) {
+        double element;
+        if(!elementToDouble(var, i, element)) {
+          UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "Data type %s of %s is not supported for aggregates.", var.type->typeName, browseName.c_str());
+          return;
+        }
+        aggregate.min[i] = std::min(aggregate.min[i], element);
+        aggregate.max[i] = std::max(aggregate.max[i], element);
+        aggregate.sum[i] += element;
+      }
+    }
+    UA_DataValue sample;
+    UA_DataValue_init(&sample);
+    if(UA_DataValue_copy(value, &sample) == UA_STATUSCODE_GOOD) {
+      aggregate.last.moveFrom(&sample);
+    }
+    ++aggregate.count;
+  }
+
+  bool MonitorItem::aggregateReady(const std::chrono::steady_clock::time_point& now) const {
+    if(aggregate.count == 0) {
+      return false;
+    }
+    if(aggregate.settings.aggregateSamples > 0) {
+      return aggregate.count >= aggregate.settings.aggregateSamples;
+    }
+    return std::chrono::duration<double, std::milli>(now - aggregate.windowStart).count() >=
+        aggregate.settings.aggregateInterval;
+  }
+
+  void MonitorItem::finishAggregate() {
+    const UA_DataValue* newest = aggregate.last.getDataValue();
+    bool isScalar = UA_Variant_isScalar(&newest->value);
+    std::vector<double> values;
+    switch(aggregate.settings.aggregate) {
+      case OpcUAAggregateType::min:
+        values = aggregate.min;
+        break;
+      case OpcUAAggregateType::max:
+        values = aggregate.max;
+        break;
+      case OpcUAAggregateType::mean:
+        values = aggregate.sum;
+        for(auto& value : values) {
+          value /= static_cast<double>(aggregate.count);
+        }
+        break;
+      case OpcUAAggregateType::count:
+        values.assign(aggregate.sum.size(), static_cast<double>(aggregate.count));
+        break;
+      default: {
+        UA_DataValue sample;
+        UA_DataValue_init(&sample);
+        if(UA_DataValue_copy(newest, &sample) == UA_STATUSCODE_GOOD) {
+          lastValue.moveFrom(&sample);
+        }
+        aggregate.count = 0;
+        return;
+      }
+    }
+    setAggregateValue(
+        lastValue, values, isScalar, aggregate.settings.aggregate == OpcUAAggregateType::count, newest);
+    aggregate.count = 0;
+  }
+
+  void MonitorItem::setServerAggregate(const UA_DataValue* value) {
+    if(aggregate.settings.aggregate == OpcUAAggregateType::last) {
+      UA_DataValue sample;
+      UA_DataValue_init(&sample);
+      if(UA_DataValue_copy(value, &sample) == UA_STATUSCODE_GOOD) {
+        lastValue.moveFrom(&sample);
+      }
+      return;
+    }
+    // the server returns the aggregate in the data type of the node (min, max) or a type chosen by the server
+    const UA_Variant& var = value->value;
+    std::vector<double> values(numberOfElements(var));
+    for(size_t i = 0; i < values.size(); ++i) {
+      if(!elementToDouble(var, i, values[i])) {
+        UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Unexpected data type %s of aggregate received for %s.", var.type->typeName, browseName.c_str());
+        return;
+      }
+    }
+    setAggregateValue(lastValue, values, UA_Variant_isScalar(&var),
+        aggregate.settings.aggregate == OpcUAAggregateType::count, value);
+  }
+
+  void MonitorItem::push(OpcUABackendRegisterAccessorBase* accessor) const {
+    if(!accessor->isHistory()) {
+      accessor->notifications.push_overwrite(getAccessorData(lastValue.getDataValue(), accessor));
+      return;
+    }
+    if(history.empty()) {
+      if(!lastValue.hasValue()) {
+        // forward the bad status
+        accessor->notifications.push_overwrite(ManagedDataValue(lastValue.getDataValue()));
+      }
+      return;
+    }
+    // fill the array with the newest samples - the newest sample is the last element
+    bool timestamps = accessor->info->historyContent == OpcUAHistoryContent::timestamps;
+    const UA_DataValue* newest = history.back().getDataValue();
+    // the timestamps register is added to the catalogue with this type, see OpcUABackend::addCatalogueEntry()
+    const UA_DataType* type = timestamps ? &UA_TYPES[UA_TYPES_INT64] : newest->value.type;
+    size_t length = accessor->info->arrayLength;
+    size_t nSamples = std::min(length, history.size());
+    void* array = UA_Array_new(length, type);
+    if(array == nullptr) {
+      return;
+    }
+    for(size_t i = 0; i < nSamples; ++i) {
+      const UA_DataValue* sample = history[history.size() - nSamples + i].getDataValue();
+      void* target = static_cast<char*>(array) + (length - nSamples + i) * type->memSize;
+      if(timestamps) {
+        *static_cast<UA_Int64*>(target) = (sample->sourceTimestamp - UA_DATETIME_UNIX_EPOCH) * 100;
+      }
+      else if(sample->value.type == type && UA_Variant_isScalar(&sample->value)) {
+        UA_copy(sample->value.data, target, type);
+      }
+    }
+    UA_DataValue value;
+    UA_DataValue_init(&value);
+    UA_Variant_setArray(&value.value, array, length, type);
+    value.hasValue = true;
+    value.hasSourceTimestamp = newest->hasSourceTimestamp;
+    value.sourceTimestamp = newest->sourceTimestamp;
+    value.hasServerTimestamp = newest->hasServerTimestamp;
+    value.serverTimestamp = newest->serverTimestamp;
+    accessor->notifications.push_overwrite(ManagedDataValue(&value));
+    UA_DataValue_clear(&value);
+  }
+
+  ManagedDataValue MonitorItem::getAccessorData(
+      const UA_DataValue* value, const OpcUABackendRegisterAccessorBase* accessor) const {
+    if(value->hasValue && accessor->info->isMultiDimensional && !accessor->info->indexRange.empty()) {
+      // the item monitors the whole node, the register gets its rows and columns only
+      return {value, accessor->info->indexRange};
+    }
+    if(!value->hasValue || UA_Variant_isScalar(&value->value) ||
+        (indexRange.empty() && accessor->needsFullNode())) {
+      return ManagedDataValue(value);
+    }
+    size_t offset = accessor->windowStart - rangeStart;
+    if(offset == 0 && accessor->windowLength == value->value.arrayLength) {
+      return ManagedDataValue(value);
+    }
+    return {value, offset, accessor->windowLength};
+  }
+
   void OPCUASubscriptionManager::deleteSubscriptionCallback(
       UA_Client* client, UA_UInt32 subscriptionId, void* /*subscriptionContext*/) {
     UA_LOG_INFO(
@@ -33,7 +456,10 @@ namespace ChimeraTK {
           &OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "No client found in the deleteSubscriptionCallback.");
       return;
     }
-    OpcUABackend::backendClients[client]->_subscriptionManager->setInactive();
+    auto subscriptionManager = OpcUABackend::backendClients[client]->getLane(client).second;
+    if(subscriptionManager) {
+      subscriptionManager->setInactive();
+    }
   };
 
   OPCUASubscriptionManager::~OPCUASubscriptionManager() {
@@ -64,6 +490,16 @@ namespace ChimeraTK {
   void OPCUASubscriptionManager::runClient() {
     UA_StatusCode ret;
     UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Starting client iterate loop.");
+    if(_connection->realtimePriority > 0) {
+      sched_param param{};
+      param.sched_priority = _connection->realtimePriority;
+      int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+      if(err != 0) {
+        UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Failed to set real-time priority %d for the client thread: %s", _connection->realtimePriority,
+            strerror(err));
+      }
+    }
     uint64_t i = 0;
     while(_run) {
       UA_LOG_TRACE(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Sending subscription request.");
@@ -74,6 +510,8 @@ namespace ChimeraTK {
           break;
         }
       }
+      pushPendingItems();
+      releasePooledItems();
       if(ret != UA_STATUSCODE_GOOD) {
         UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
             "Stopped sending publish requests. OPC UA message: %s", UA_StatusCode_name(ret));
@@ -106,15 +544,21 @@ namespace ChimeraTK {
     if(!_subscriptionActive) {
       createSubscription();
     }
+    // samples missed while the connection was lost are older than the current values pushed below
+    backfillHistory();
     _asyncReadActive = true;
     if(_items.size() > 0 && subscriptionMap.size() == 0) {
       addMonitoredItems();
     }
     else {
-      std::lock_guard<std::mutex> lock(mutex);
-      for(auto& item : _items) {
-        item.active = true;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto& item : _items) {
+          item.active = true;
+        }
       }
+      // initial values received before activation were not pushed
+      prefetchInitialValues();
     }
   }
 
@@ -124,7 +568,7 @@ namespace ChimeraTK {
     {
       std::lock_guard<std::mutex> lock(mutex);
       for(auto& item : subscriptionMap) {
-        item.second->active = false;
+        item.second.first->active = false;
       }
     }
     if(_run) {
@@ -172,15 +616,52 @@ namespace ChimeraTK {
     auto* base = reinterpret_cast<OPCUASubscriptionManager*>(monContext);
 
     try {
-      if(base->subscriptionMap.at(monId)->active) {
+      auto [item, chunk] = base->subscriptionMap.at(monId);
+      if(item->active) {
         // only lock the mutex if active. This is used when unsubscribing to avoid dead locks
         std::lock_guard<std::mutex> lock(base->mutex);
-        base->subscriptionMap[monId]->hasException = false;
-        UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Pushing data to queue for %zu accessors.",
-            base->subscriptionMap[monId]->accessors.size());
-        for(auto& accessor : base->subscriptionMap[monId]->accessors) {
-          ManagedDataValue data(value);
-          accessor->notifications.push_overwrite(std::move(data));
+        item->hasException = false;
+        if(item->isAggregate() && value->hasValue) {
+          if(item->aggregate.onServer) {
+            item->setServerAggregate(value);
+            for(auto& accessor : item->accessors) {
+              item->push(accessor);
+            }
+          }
+          else {
+            // complete windows are pushed in pushPendingItems()
+            item->addSample(value);
+          }
+        }
+        else if(item->isAggregate()) {
+          // only forward the bad status - the last aggregate is kept
+          for(auto& accessor : item->accessors) {
+            accessor->notifications.push_overwrite(ManagedDataValue(value));
+          }
+        }
+        else if(item->chunks.size() > 1 && value->hasValue) {
+          // chunks received in the same client iteration are pushed together in pushPendingItems()
+          item->updateChunk(chunk, value);
+          base->_itemsPending = true;
+        }
+        else if(item->chunks.size() > 1) {
+          // keep the assembled data and only forward the bad status
+          for(auto& accessor : item->accessors) {
+            accessor->notifications.push_overwrite(ManagedDataValue(value));
+          }
+        }
+        else if(item->prefetched && value->hasValue && value->sourceTimestamp == item->lastValue.getSourceTime()) {
+          // the initial value was already read and pushed by prefetchInitialValues()
+          item->prefetched = false;
+        }
+        else {
+          item->prefetched = false;
+          // the notification is cleared by the client after the callback returns, so its content can be taken over
+          base->updateItem(*item, value);
+        }
+        if(!item->initialized && (item->chunks.size() == 1 || item->isComplete() || !value->hasValue)) {
+          item->initialized = true;
+          base->_initialValueCondition.notify_all();
         }
       }
     }
@@ -192,6 +673,278 @@ namespace ChimeraTK {
     }
   }
 
+  void OPCUASubscriptionManager::updateItem(MonitorItem& item, UA_DataValue* value) {
+    item.lastValue.moveFrom(value);
+    if(item.lastValue.hasValue() && !item.accessors.empty() && item.accessors.front()->info->structure) {
+      // all accessors of a structure node are field registers - the structure is decoded once for all of them
+      item.accessors.front()->info->structure->decode(*item.lastValue.getVariant());
+    }
+    UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Pushing data to queue for %zu accessors.",
+        item.accessors.size());
+    for(auto& accessor : item.accessors) {
+      if(accessor->isHistory() && item.lastValue.hasValue()) {
+        // samples are pushed together in pushPendingItems()
+        continue;
+      }
+      if(item.hasValue(accessor, item.lastValue.getSourceTime())) {
+        // the value was already pushed by the replaced item
+        continue;
+      }
+      auto data = item.getAccessorData(item.lastValue.getDataValue(), accessor);
+      accessor->notifications.push_overwrite(std::move(data));
+    }
+    item.replacedAccessors.clear();
+    if(item.queueSize > 1 && item.lastValue.hasValue()) {
+      item.appendHistory();
+      _itemsPending = true;
+    }
+  }
+
+  void OPCUASubscriptionManager::prefetchInitialValues() {
+    std::vector<std::pair<MonitorItem*, UA_UInt32>> items;
+    std::vector<UA_ReadValueId> ids;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for(auto& item : _items) {
+        // chunks are assembled from the notifications and aggregates are only available after the first window
+        if(!item.active || !item.isMonitored || item.initialized || item.chunks.size() != 1 || item.isAggregate()) {
+          continue;
+        }
+        UA_ReadValueId id;
+        UA_ReadValueId_init(&id);
+        // the node id is only borrowed from the item
+        id.nodeId = item.node;
+        id.attributeId = UA_ATTRIBUTEID_VALUE;
+        if(!item.indexRange.empty()) {
+          id.indexRange = UA_String_fromChars(item.indexRange.c_str());
+        }
+        ids.push_back(id);
+        items.emplace_back(&item, item.chunks.front().id);
+      }
+    }
+    if(ids.empty()) {
+      return;
+    }
+    UA_ReadRequest request;
+    UA_ReadRequest_init(&request);
+    request.nodesToRead = ids.data();
+    request.nodesToReadSize = ids.size();
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    UA_ReadResponse response;
+    {
+      std::lock_guard<std::mutex> lock(_connection->client_lock);
+      for(auto& id : ids) {
+        id.nodeId = _connection->resolve(id.nodeId);
+      }
+      response = UA_Client_Service_read(_connection->client.get(), request);
+    }
+    for(auto& id : ids) {
+      UA_String_clear(&id.indexRange);
+    }
+    UA_StatusCode status = response.responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD && response.resultsSize != ids.size()) {
+      status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    if(status != UA_STATUSCODE_GOOD) {
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed to read initial values of %zu monitored items (%s). Waiting for the first publish response.",
+          ids.size(), UA_StatusCode_name(status));
+      UA_ReadResponse_clear(&response);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for(size_t i = 0; i < items.size(); ++i) {
+        auto [item, id] = items[i];
+        // the item might be removed or recreated while reading and the notification might be received already
+        auto it = subscriptionMap.find(id);
+        if(it == subscriptionMap.end() || it->second.first != item || !item->active || item->initialized) {
+          continue;
+        }
+        updateItem(*item, &response.results[i]);
+        item->prefetched = true;
+        item->initialized = true;
+      }
+    }
+    _initialValueCondition.notify_all();
+    UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Read initial values of %zu monitored items.",
+        ids.size());
+    UA_ReadResponse_clear(&response);
+  }
+
+  void OPCUASubscriptionManager::backfillHistory() {
+    std::vector<BackfillNode> nodes;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for(auto& item : _items) {
+        size_t backfillLength = 0;
+        for(auto* accessor : item.accessors) {
+          backfillLength = std::max(backfillLength, accessor->info->options.backfillLength);
+        }
+        // without a last value the accessors did not see data before, so there is no gap
+        if(backfillLength == 0 || !item.lastValue.hasValue() || item.isAggregate() || item.chunkSize != 0 ||
+            !item.channels.empty()) {
+          continue;
+        }
+        BackfillNode node{&item, item.lastValue.getSourceTime(), (UA_UInt32)backfillLength, {}};
+        UA_HistoryReadValueId_init(&node.id);
+        // the node id is copied, since the item might be removed while reading
+        UA_NodeId_copy(&item.node, &node.id.nodeId);
+        if(!item.indexRange.empty()) {
+          node.id.indexRange = UA_String_fromChars(item.indexRange.c_str());
+        }
+        nodes.push_back(node);
+      }
+    }
+    if(nodes.empty()) {
+      return;
+    }
+#ifdef UA_ENABLE_HISTORIZING
+    // a common start time or length would let the samples of one node use up the length of another one
+    std::sort(nodes.begin(), nodes.end(), [](const BackfillNode& a, const BackfillNode& b) {
+      return a.lastTime < b.lastTime || (a.lastTime == b.lastTime && a.length < b.length);
+    });
+    size_t nSamples = 0;
+    for(size_t first = 0; first < nodes.size();) {
+      size_t last = first + 1;
+      while(last < nodes.size() && nodes[last].lastTime == nodes[first].lastTime &&
+          nodes[last].length == nodes[first].length) {
+        ++last;
+      }
+      nSamples += readHistory(&nodes[first], last - first);
+      first = last;
+    }
+    UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+        "Delivered %zu samples missed during the connection loss.", nSamples);
+#else
+    UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+        "open62541 was built without history support. Samples missed by %zu nodes during the connection loss are not "
+        "delivered.",
+        nodes.size());
+#endif
+    for(auto& node : nodes) {
+      UA_HistoryReadValueId_clear(&node.id);
+    }
+  }
+
+#ifdef UA_ENABLE_HISTORIZING
+  size_t OPCUASubscriptionManager::readHistory(BackfillNode* nodes, size_t nNodes) {
+    UA_ReadRawModifiedDetails details;
+    UA_ReadRawModifiedDetails_init(&details);
+    // the last value is already known by the accessors
+    details.startTime = nodes[0].lastTime + 1;
+    details.endTime = UA_DateTime_now();
+    details.numValuesPerNode = nodes[0].length;
+    // the ids are only borrowed from the nodes
+    std::vector<UA_HistoryReadValueId> ids;
+    for(size_t i = 0; i < nNodes; ++i) {
+      ids.push_back(nodes[i].id);
+    }
+    UA_HistoryReadRequest request;
+    UA_HistoryReadRequest_init(&request);
+    // details and ids are only borrowed - the request is not cleared
+    UA_ExtensionObject_setValue(&request.historyReadDetails, &details, &UA_TYPES[UA_TYPES_READRAWMODIFIEDDETAILS]);
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    request.nodesToRead = ids.data();
+    request.nodesToReadSize = ids.size();
+    UA_HistoryReadResponse response;
+    {
+      std::lock_guard<std::mutex> lock(_connection->client_lock);
+      for(auto& id : ids) {
+        id.nodeId = _connection->resolve(id.nodeId);
+      }
+      response = UA_Client_Service_historyRead(_connection->client.get(), request);
+    }
+    UA_StatusCode status = response.responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD && response.resultsSize != ids.size()) {
+      status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    if(status != UA_STATUSCODE_GOOD) {
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed to read the history of %zu nodes after reconnecting (%s). Samples missed during the connection loss "
+          "are not delivered.",
+          ids.size(), UA_StatusCode_name(status));
+      UA_HistoryReadResponse_clear(&response);
+      return 0;
+    }
+    size_t nSamples = 0;
+    std::vector<UA_HistoryReadValueId> continued;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for(size_t i = 0; i < nNodes; ++i) {
+        auto& result = response.results[i];
+        if(result.continuationPoint.length > 0) {
+          // the continuation point is taken over by the node and released below
+          nodes[i].id.continuationPoint = result.continuationPoint;
+          UA_ByteString_init(&result.continuationPoint);
+          continued.push_back(nodes[i].id);
+        }
+        // the item might be removed while reading
+        auto* item = nodes[i].item;
+        bool exists =
+            std::any_of(_items.begin(), _items.end(), [&](const MonitorItem& other) { return &other == item; });
+        if(!exists || result.statusCode != UA_STATUSCODE_GOOD ||
+            !UA_ExtensionObject_hasDecodedType(&result.historyData, &UA_TYPES[UA_TYPES_HISTORYDATA])) {
+          continue;
+        }
+        if(nodes[i].id.continuationPoint.length > 0) {
+          UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "More than %u samples of %s were missed. Only the oldest ones are delivered.", nodes[i].length,
+              item->browseName.c_str());
+        }
+        auto* data = static_cast<UA_HistoryData*>(result.historyData.content.decoded.data);
+        // the server returns the samples sorted by the source time stamp - the oldest first
+        for(size_t j = 0; j < data->dataValuesSize; ++j) {
+          if(data->dataValues[j].sourceTimestamp <= nodes[i].lastTime) {
+            continue;
+          }
+          updateItem(*item, &data->dataValues[j]);
+          ++nSamples;
+        }
+      }
+    }
+    UA_HistoryReadResponse_clear(&response);
+    if(!continued.empty()) {
+      // the server keeps continuation points until they are released or the session is closed
+      request.releaseContinuationPoints = true;
+      request.nodesToRead = continued.data();
+      request.nodesToReadSize = continued.size();
+      {
+        std::lock_guard<std::mutex> lock(_connection->client_lock);
+        for(auto& id : continued) {
+          id.nodeId = _connection->resolve(id.nodeId);
+        }
+        response = UA_Client_Service_historyRead(_connection->client.get(), request);
+      }
+      if(response.responseHeader.serviceResult != UA_STATUSCODE_GOOD) {
+        UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Failed to release %zu continuation points (%s).", continued.size(),
+            UA_StatusCode_name(response.responseHeader.serviceResult));
+      }
+      UA_HistoryReadResponse_clear(&response);
+    }
+    return nSamples;
+  }
+#endif
+
+  bool OPCUASubscriptionManager::waitForInitialValues() {
+    auto timeout = std::chrono::milliseconds(2 * _connection->publishingInterval + _connection->connectionTimeout);
+    std::unique_lock<std::mutex> lock(mutex);
+    auto isInitialized = [](const MonitorItem& item) { return !item.active || !item.isMonitored || item.initialized; };
+    bool received = _initialValueCondition.wait_for(
+        lock, timeout, [&] { return !_run || std::all_of(_items.begin(), _items.end(), isInitialized); });
+    if(!received) {
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Not all initial values were received within %ldms.", (long)timeout.count());
+    }
+    return received;
+  }
+
+  size_t OPCUASubscriptionManager::getNumberOfMonitoredItems() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return subscriptionMap.size();
+  }
+
   void OPCUASubscriptionManager::createSubscription() {
     /* Clean up left over subscription. */
     if(_subscriptionID != 0) {
@@ -200,16 +953,28 @@ namespace ChimeraTK {
     /* Create the subscription with default configuration. */
     UA_CreateSubscriptionRequest request = UA_CreateSubscriptionRequest_default();
     request.requestedPublishingInterval = _connection->publishingInterval;
+    size_t nNotifications = countNotifications();
     UA_CreateSubscriptionResponse response;
     {
       std::lock_guard<std::mutex> lock(_connection->client_lock);
+      _connection->measureRoundTripTime();
+      _activeSettings = deriveSettings(nNotifications);
+      request.requestedLifetimeCount = _activeSettings.lifetimeCount;
+      request.requestedMaxKeepAliveCount = _activeSettings.maxKeepAliveCount;
+      request.maxNotificationsPerPublish = _activeSettings.maxNotificationsPerPublish;
+      _connection->config->outStandingPublishRequests = _activeSettings.publishRequests;
       response =
           UA_Client_Subscriptions_create(_connection->client.get(), request, NULL, NULL, deleteSubscriptionCallback);
     }
     if(response.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
       _subscriptionID = response.subscriptionId;
-      UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Create subscription succeeded, id %u",
-          _subscriptionID);
+      _activeSettings.lifetimeCount = response.revisedLifetimeCount;
+      _activeSettings.maxKeepAliveCount = response.revisedMaxKeepAliveCount;
+      UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Create subscription succeeded, id %u (round trip time: %fms, publish requests: %u, max. notifications per "
+          "publish: %u, lifetime count: %u, keep alive count: %u)",
+          _subscriptionID, _connection->roundTripTime, _activeSettings.publishRequests,
+          _activeSettings.maxNotificationsPerPublish, _activeSettings.lifetimeCount, _activeSettings.maxKeepAliveCount);
       if(response.revisedPublishingInterval != _connection->publishingInterval) {
         UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
             "Publishing interval was changed from %fms to %fms", _connection->publishingInterval,
@@ -225,6 +990,66 @@ namespace ChimeraTK {
     }
   }
 
+  size_t OPCUASubscriptionManager::countNotifications() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t nNotifications = 0;
+    for(const auto& item : _items) {
+      // each queued sample is a separate notification
+      nNotifications += std::max<size_t>(1, item.chunks.size()) * item.queueSize;
+    }
+    return nNotifications;
+  }
+
+  SubscriptionSettings OPCUASubscriptionManager::deriveSettings(size_t nNotifications) const {
+    SubscriptionSettings settings = _connection->subscriptionSettings;
+    auto interval = std::max(1., (double)_connection->publishingInterval);
+    auto roundTrips = (UA_UInt32)std::ceil(_connection->roundTripTime / interval);
+    if(settings.publishRequests == 0) {
+      settings.publishRequests = (UA_UInt16)std::clamp<UA_UInt32>(roundTrips + 1, 2, maxPublishRequests);
+    }
+    if(settings.maxNotificationsPerPublish == 0) {
+      settings.maxNotificationsPerPublish = std::max<UA_UInt32>(minNotificationsPerPublish, 2 * nNotifications);
+    }
+    if(settings.maxKeepAliveCount == 0) {
+      settings.maxKeepAliveCount = std::max<UA_UInt32>(10, 3 * roundTrips);
+    }
+    if(settings.lifetimeCount == 0) {
+      settings.lifetimeCount = std::max<UA_UInt32>(10000, 3 * settings.maxKeepAliveCount);
+    }
+    return settings;
+  }
+
+  void OPCUASubscriptionManager::updateSubscriptionSettings() {
+    auto settings = deriveSettings(countNotifications());
+    if(settings.maxNotificationsPerPublish == _activeSettings.maxNotificationsPerPublish || _subscriptionID == 0) {
+      return;
+    }
+    UA_ModifySubscriptionRequest request;
+    UA_ModifySubscriptionRequest_init(&request);
+    request.subscriptionId = _subscriptionID;
+    request.requestedPublishingInterval = _connection->publishingInterval;
+    request.requestedLifetimeCount = _activeSettings.lifetimeCount;
+    request.requestedMaxKeepAliveCount = _activeSettings.maxKeepAliveCount;
+    request.maxNotificationsPerPublish = settings.maxNotificationsPerPublish;
+    UA_ModifySubscriptionResponse response;
+    {
+      std::lock_guard<std::mutex> lock(_connection->client_lock);
+      response = UA_Client_Subscriptions_modify(_connection->client.get(), request);
+    }
+    if(response.responseHeader.serviceResult == UA_STATUSCODE_GOOD) {
+      UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Changed max. notifications per publish of subscription %u to %u.", _subscriptionID,
+          settings.maxNotificationsPerPublish);
+      _activeSettings.maxNotificationsPerPublish = settings.maxNotificationsPerPublish;
+    }
+    else {
+      UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed to modify subscription %u. Error: %s", _subscriptionID,
+          UA_StatusCode_name(response.responseHeader.serviceResult));
+    }
+    UA_ModifySubscriptionResponse_clear(&response);
+  }
+
   void OPCUASubscriptionManager::addMonitoredItems() {
     mutex.lock();
     for(auto& item : _items) {
@@ -232,49 +1057,163 @@ namespace ChimeraTK {
         item.active = true;
       }
       if(!item.isMonitored) {
-        // create monitored item
-        // pass object as context to the callback function. This allows to use individual subscriptionMaps for each manager!
-        UA_MonitoredItemCreateRequest monRequest = UA_MonitoredItemCreateRequest_default(item.node);
-        // sampling interval equal to the publishing interval set for the subscription
-        if(!item.accessors.at(0)->info->indexRange.empty()) {
+        UA_StatusCode status = createMonitoredItems(item);
+        if(item.isAggregate() && item.aggregate.onServer && isFilterError(status)) {
           UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
-              "Using data range %s for monitored item of %s.", item.accessors.at(0)->info->indexRange.c_str(),
-              item.browseName.c_str());
-          monRequest.itemToMonitor.indexRange = UA_String_fromChars(item.accessors.at(0)->info->indexRange.c_str());
-        }
-
-        monRequest.requestedParameters.samplingInterval = _connection->publishingInterval;
-        UA_MonitoredItemCreateResult monResponse;
-        // unlock mutex because the OPC UA call potentially ends up in a state callback which enters deactivateAllAndPushException
-        mutex.unlock();
-        {
-          std::lock_guard<std::mutex> lock(_connection->client_lock);
-          monResponse = UA_Client_MonitoredItems_createDataChange(_connection->client.get(), _subscriptionID,
-              UA_TIMESTAMPSTORETURN_BOTH, monRequest, this, &OPCUASubscriptionManager::responseHandler, NULL);
-        }
-        mutex.lock();
-        /* Check server response to adding the item to be monitored. */
-        if(monResponse.statusCode == UA_STATUSCODE_GOOD) {
-          item.id = monResponse.monitoredItemId;
-          UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Monitoring id %u (%s) for pv: %s",
-              item.id, _connection->serverAddress.c_str(), item.browseName.c_str());
-          if(monResponse.revisedSamplingInterval != _connection->publishingInterval) {
-            UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
-                "Publishing interval was changed from %fms to %fms", _connection->publishingInterval,
-                monResponse.revisedSamplingInterval);
-          }
-          subscriptionMap[item.id] = &item;
-          item.isMonitored = true;
+              "Server does not support aggregate %s for %s (%s). The aggregate is computed by the backend.",
+              toString(item.aggregate.settings.aggregate).c_str(), item.browseName.c_str(), UA_StatusCode_name(status));
+          item.aggregate.onServer = false;
+          status = createMonitoredItems(item);
         }
-        else {
+        if(status != UA_STATUSCODE_GOOD) {
+          auto itemName = item.browseName;
           mutex.unlock();
-          handleException(std::string("Failed to add monitored item for node: ") + item.browseName +
-              " Error: " + UA_StatusCode_name(monResponse.statusCode));
+          handleException(std::string("Failed to add monitored item for node: ") + itemName +
+              " Error: " + UA_StatusCode_name(status));
           mutex.lock();
         }
+        else if(item.isAggregate() && !item.aggregate.onServer) {
+          _clientAggregates = true;
+        }
       }
     }
     mutex.unlock();
+    updateSubscriptionSettings();
+    prefetchInitialValues();
+  }
+
+  UA_StatusCode OPCUASubscriptionManager::createMonitoredItems(MonitorItem& item) {
+    // the range might be wider than needed if accessors were removed while the item was monitored
+    item.updateRange();
+    // create one monitored item per chunk
+    item.createChunks();
+    std::vector<UA_MonitoredItemCreateRequest> monRequests;
+    for(const auto& chunk : item.chunks) {
+      UA_MonitoredItemCreateRequest monRequest = UA_MonitoredItemCreateRequest_default(item.node);
+      std::string range = item.indexRange;
+      if(item.chunks.size() > 1 && item.channels.empty()) {
+        size_t first = item.rangeStart + chunk.start;
+        range = chunk.length == 1 ? std::to_string(first) :
+                                    std::to_string(first) + ":" + std::to_string(first + chunk.length - 1);
+      }
+      if(!range.empty()) {
+        monRequest.itemToMonitor.indexRange = UA_String_fromChars(range.c_str());
+      }
+      // sampling interval equal to the publishing interval set for the subscription
+      monRequest.requestedParameters.samplingInterval = _connection->publishingInterval;
+      if(item.queueSize > 1) {
+        // sample as fast as possible and keep all samples between two publishes
+        monRequest.requestedParameters.samplingInterval = 0;
+        monRequest.requestedParameters.queueSize = item.queueSize;
+        monRequest.requestedParameters.discardOldest = true;
+      }
+      if(item.isAggregate()) {
+        setAggregateParameters(item, monRequest);
+      }
+      monRequests.push_back(monRequest);
+    }
+    if(!item.channels.empty()) {
+      UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Using %zu monitored items for the channels of %s.", item.chunks.size(), item.browseName.c_str());
+    }
+    else if(item.chunks.size() > 1) {
+      UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Using %zu chunks of %zu elements for monitored item of %s.", item.chunks.size(), item.chunkSize,
+          item.browseName.c_str());
+    }
+    else if(!item.indexRange.empty()) {
+      UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Using data range %s for monitored item of %s.", item.indexRange.c_str(), item.browseName.c_str());
+    }
+    if(item.queueSize > 1) {
+      UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Using queue size %zu for monitored item of %s.", item.queueSize, item.browseName.c_str());
+    }
+    UA_CreateMonitoredItemsRequest request;
+    UA_CreateMonitoredItemsRequest_init(&request);
+    request.subscriptionId = _subscriptionID;
+    request.timestampsToReturn = UA_TIMESTAMPSTORETURN_BOTH;
+    request.itemsToCreate = monRequests.data();
+    request.itemsToCreateSize = monRequests.size();
+    // pass object as context to the callback function. This allows to use individual subscriptionMaps for each manager!
+    std::vector<void*> contexts(monRequests.size(), this);
+    std::vector<UA_Client_DataChangeNotificationCallback> callbacks(
+        monRequests.size(), &OPCUASubscriptionManager::responseHandler);
+    std::vector<UA_Client_DeleteMonitoredItemCallback> deleteCallbacks(monRequests.size(), nullptr);
+    UA_CreateMonitoredItemsResponse monResponse;
+    // unlock mutex because the OPC UA call potentially ends up in a state callback which enters
+    // deactivateAllAndPushException
+    mutex.unlock();
+    {
+      std::lock_guard<std::mutex> lock(_connection->client_lock);
+      for(size_t i = 0; i < monRequests.size(); ++i) {
+        monRequests[i].itemToMonitor.nodeId = _connection->resolve(item.getChunkNode(i));
+      }
+      monResponse = UA_Client_MonitoredItems_createDataChanges(
+          _connection->client.get(), request, contexts.data(), callbacks.data(), deleteCallbacks.data());
+    }
+    for(auto& monRequest : monRequests) {
+      // the node id is only borrowed from the item
+      UA_String_clear(&monRequest.itemToMonitor.indexRange);
+      UA_ExtensionObject_clear(&monRequest.requestedParameters.filter);
+    }
+    mutex.lock();
+    /* Check server response to adding the items to be monitored. */
+    UA_StatusCode status = monResponse.responseHeader.serviceResult;
+    if(status == UA_STATUSCODE_GOOD && monResponse.resultsSize != item.chunks.size()) {
+      status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+    }
+    for(size_t i = 0; i < monResponse.resultsSize && i < item.chunks.size(); ++i) {
+      const auto& result = monResponse.results[i];
+      if(result.statusCode != UA_STATUSCODE_GOOD) {
+        status = status == UA_STATUSCODE_GOOD ? result.statusCode : status;
+        continue;
+      }
+      item.chunks[i].id = result.monitoredItemId;
+      subscriptionMap[item.chunks[i].id] = {&item, i};
+      if(i == 0 && item.queueSize == 1 && !item.isAggregate() &&
+          result.revisedSamplingInterval != _connection->publishingInterval) {
+        UA_LOG_WARNING(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Publishing interval was changed from %fms to %fms", _connection->publishingInterval,
+            result.revisedSamplingInterval);
+      }
+    }
+    UA_CreateMonitoredItemsResponse_clear(&monResponse);
+    if(status == UA_STATUSCODE_GOOD) {
+      UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Monitoring id %u (%s, %zu monitored items) for pv: %s", item.chunks.front().id,
+          _connection->serverAddress.c_str(), item.chunks.size(), item.browseName.c_str());
+      item.isMonitored = true;
+      item.initialized = item.isAggregate();
+      item.prefetched = false;
+    }
+    else {
+      // do not keep a partially monitored item - it is added again by the next call of addMonitoredItems
+      auto ids = releaseMonitoredItems(item);
+      auto itemName = item.browseName;
+      mutex.unlock();
+      removeMonitoredItems(ids, itemName);
+      mutex.lock();
+    }
+    return status;
+  }
+
+  void OPCUASubscriptionManager::setAggregateParameters(
+      const MonitorItem& item, UA_MonitoredItemCreateRequest& request) const {
+    if(!item.aggregate.onServer) {
+      // receive every sample and compute the aggregate in the backend
+      request.requestedParameters.samplingInterval = 0;
+      request.requestedParameters.queueSize = std::max<UA_UInt32>(item.queueSize, aggregateQueueSize);
+      request.requestedParameters.discardOldest = true;
+      return;
+    }
+    UA_AggregateFilter filter;
+    UA_AggregateFilter_init(&filter);
+    filter.startTime = UA_DateTime_now();
+    filter.aggregateType = aggregateFunction(item.aggregate.settings.aggregate);
+    filter.processingInterval = item.aggregate.settings.aggregateInterval;
+    filter.aggregateConfiguration.useServerCapabilitiesDefaults = true;
+    UA_ExtensionObject_setValueCopy(&request.requestedParameters.filter, &filter, &UA_TYPES[UA_TYPES_AGGREGATEFILTER]);
   }
 
   void OPCUASubscriptionManager::prepare() {
@@ -284,17 +1223,41 @@ namespace ChimeraTK {
 
   void OPCUASubscriptionManager::subscribe(
       const std::string& browseName, const UA_NodeId& node, OpcUABackendRegisterAccessorBase* accessor) {
-    //\ToDo: Check if already monitored based on node using the NodeStore?!
-    std::deque<MonitorItem>::iterator it;
+    if(opcuaThread && !_run) {
+      // the client thread stopped itself, e.g. after releasing the last pooled item - wait until it removed the
+      // subscription, so a new one is created and the thread is started again for the accessor
+      stopClientThread();
+    }
     mutex.lock();
-    it = std::find(_items.begin(), _items.end(), browseName);
+    // Use an item covering the window of the accessor or one that is not monitored yet. Else a monitored item of the
+    // node is replaced by an item covering the windows of all its accessors and of the new one.
+    auto it = std::find_if(_items.begin(), _items.end(), [&](const MonitorItem& item) {
+      return item.matches(node, *accessor->info) && !item.replaced && (!item.isMonitored || item.covers(accessor));
+    });
 
     if(it == _items.end()) {
-      /* Request monitoring for the node of interest. */
-      MonitorItem item(browseName, node, accessor);
-      _items.push_back(item);
+      // only replace items in use - the monitored items of the replacement are created below
+      auto monitored = _items.end();
+      if(_asyncReadActive) {
+        monitored = std::find_if(_items.begin(), _items.end(), [&](const MonitorItem& item) {
+          return item.matches(node, *accessor->info) && item.isMonitored && !item.isPooled();
+        });
+      }
+      std::vector<UA_UInt32> ids;
+      if(monitored != _items.end()) {
+        auto accessors = monitored->accessors;
+        accessors.push_back(accessor);
+        replaceItem(monitored, accessors, ids);
+      }
+      else {
+        /* Request monitoring for the node of interest. */
+        _items.emplace_back(browseName, node, accessor);
+      }
 
       mutex.unlock();
+      if(!ids.empty() && _connection->isConnected()) {
+        removeMonitoredItems(ids, browseName);
+      }
       // check if device was already opened
       if(_asyncReadActive) {
         // This can happen if async read was activated without any RegisterAccessors using the subscription.
@@ -308,31 +1271,29 @@ namespace ChimeraTK {
       }
     }
     else {
-      UA_LOG_DEBUG(
-          &OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Adding accessor to existing node subscription.");
-      auto* tmp = it->accessors.back();
+      if(it->isPooled()) {
+        UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Reusing pooled monitored item of %s for %s.", it->browseName.c_str(), browseName.c_str());
+        it->browseName = browseName;
+      }
+      else {
+        UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+            "Adding accessor for %s to existing node subscription of %s.", browseName.c_str(), it->browseName.c_str());
+      }
       it->accessors.push_back(accessor);
+      if(!it->isMonitored) {
+        it->updateRange();
+      }
       if(it->active) {
         // if already active add initial value
         UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
             "Setting initial value for accessor with existing node subscription.");
-        std::lock_guard<std::mutex> lock(tmp->dataUpdateLock);
-        // wait for initial values that might be process in postRead at the moment
-        if(tmp->notifications.empty()) {
-          if(tmp->data.hasValue()) {
-            ManagedDataValue data(tmp->data);
-            accessor->notifications.push_overwrite(std::move(data));
-          }
-          else {
-            UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
-                "No initial value available for accessor with existing node subscription.");
-          }
+        if(it->isComplete()) {
+          it->push(accessor);
         }
         else {
-          ManagedDataValue data(tmp->notifications.front());
-          if(data.hasValue()) {
-            accessor->notifications.push_overwrite(std::move(data));
-          }
+          UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+              "No initial value available for accessor with existing node subscription.");
         }
       }
       mutex.unlock();
@@ -344,8 +1305,13 @@ namespace ChimeraTK {
 
   void OPCUASubscriptionManager::resetMonitoredItems() {
     std::lock_guard<std::mutex> lock(mutex);
+    // pooled items are not created again
+    _items.remove_if([](const MonitorItem& item) { return item.isPooled(); });
+    _hasPooledItems = false;
     for(auto& item : _items) {
       item.isMonitored = false;
+      item.chunks.clear();
+      item.replacedAccessors.clear();
     }
     subscriptionMap.clear();
   }
@@ -356,46 +1322,58 @@ namespace ChimeraTK {
       opcuaThread.reset(nullptr);
     }
   }
-  void OPCUASubscriptionManager::unsubscribe(
-      const std::string& browseName, OpcUABackendRegisterAccessorBase* accessor) {
-    // If the id is set an item is to be removed from the client. Before the _mutex lock is released.
-    UA_UInt32 id{0};
+  void OPCUASubscriptionManager::unsubscribe(const UA_NodeId& node, OpcUABackendRegisterAccessorBase* accessor) {
+    // If ids are set monitored items are to be removed from the client. Before the _mutex lock is released.
+    std::vector<UA_UInt32> ids;
+    std::string browseName;
+    bool replaced = false;
     {
       std::lock_guard<std::mutex> item_lock(mutex);
       // client pointer might be reset already when closing the device - in this case nothing to do here
-      auto it = std::find(_items.begin(), _items.end(), browseName);
+      // several items might monitor the node, so look for the item used by the accessor
+      auto it = std::find_if(_items.begin(), _items.end(), [&](const MonitorItem& item) {
+        return item.matches(node, *accessor->info) &&
+            std::find(item.accessors.begin(), item.accessors.end(), accessor) != item.accessors.end();
+      });
       // in case the asyncread was activated but no variables were subscribed - unsubscribe is called by RegisterAccessor destructor
       if(it == _items.end()) {
         return;
       }
+      browseName = it->browseName;
       if(it->accessors.size() > 1) {
         // only remove accessor if still other accessors are using that subscription
         it->accessors.erase(std::find(it->accessors.begin(), it->accessors.end(), accessor));
+        it->replacedAccessors.erase(std::remove(it->replacedAccessors.begin(), it->replacedAccessors.end(), accessor),
+            it->replacedAccessors.end());
+        if(!it->isMonitored) {
+          it->updateRange();
+        }
+        else if(_asyncReadActive) {
+          // the range is reduced by replacing the monitored item - the accessors left keep their values
+          auto accessors = it->accessors;
+          replaced = &replaceItem(it, accessors, ids) != &*it;
+        }
+      }
+      else if(it->isMonitored && _run && _connection->subscriptionSettings.itemGracePeriod > 0) {
+        // keep the monitored item for accessors created later - it is removed by releasePooledItems()
+        UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Keeping monitored item of %s in the pool.",
+            browseName.c_str());
+        it->accessors.clear();
+        it->pooledSince = std::chrono::steady_clock::now();
+        _hasPooledItems = true;
       }
       else {
         // remove monitored item
-        subscriptionMap.erase(it->id);
-        id = it->id;
+        ids = releaseMonitoredItems(*it);
         _items.erase(it);
       }
     }
+    if(replaced) {
+      addMonitoredItems();
+    }
     // try to unsubscribe
-    if(id != 0 && _connection->isConnected()) {
-      UA_StatusCode ret;
-      {
-        std::lock_guard<std::mutex> connection_lock(_connection->client_lock);
-        // UA_Client_MonitoredItems_deleteSingle tries to update the latest value which triggers responseHandler
-        ret = UA_Client_MonitoredItems_deleteSingle(_connection->client.get(), _subscriptionID, id);
-      }
-
-      if(!ret) {
-        UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Monitored item removed for: %s",
-            browseName.c_str());
-      }
-      else {
-        UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
-            "Failed to unsubscribe item (no client alive): %s Error: %s", browseName.c_str(), UA_StatusCode_name(ret));
-      }
+    if(!ids.empty() && _connection->isConnected()) {
+      removeMonitoredItems(ids, browseName);
       if(_items.size() == 0) {
         // remove subscription
         {
@@ -408,6 +1386,168 @@ namespace ChimeraTK {
     }
   }
 
+  MonitorItem& OPCUASubscriptionManager::replaceItem(std::list<MonitorItem>::iterator old,
+      const std::vector<OpcUABackendRegisterAccessorBase*>& accessors, std::vector<UA_UInt32>& ids) {
+    auto& item = _items.emplace_back(old->browseName, old->node, accessors.front());
+    item.accessors = accessors;
+    // the server might not support the aggregate of the old item
+    item.aggregate.onServer = old->aggregate.onServer;
+    item.updateRange();
+    if(item.indexRange == old->indexRange && item.chunkSize == old->chunkSize && item.queueSize == old->queueSize) {
+      // nothing to gain from creating the monitored items again
+      _items.pop_back();
+      old->accessors = accessors;
+      return *old;
+    }
+    if(old->lastValue.hasValue()) {
+      item.replacedAccessors = old->accessors;
+      item.replacedSourceTime = old->lastValue.getSourceTime();
+    }
+    else {
+      // the old item did not receive a value yet, so its accessors still have the values of the item it replaced
+      item.replacedAccessors = old->replacedAccessors;
+      item.replacedSourceTime = old->replacedSourceTime;
+    }
+    UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+        "Replacing monitored item of %s with range '%s' by an item with range '%s'.", old->browseName.c_str(),
+        old->indexRange.c_str(), item.indexRange.c_str());
+    if(_run) {
+      // removed with the next pooled items regardless of the grace period, so accessors are not blocked by the removal
+      old->accessors.clear();
+      old->replaced = true;
+      old->pooledSince = {};
+      _hasPooledItems = true;
+    }
+    else {
+      auto oldIds = releaseMonitoredItems(*old);
+      ids.insert(ids.end(), oldIds.begin(), oldIds.end());
+      _items.erase(old);
+    }
+    return item;
+  }
+
+  void OPCUASubscriptionManager::removeMonitoredItems(
+      const std::vector<UA_UInt32>& ids, const std::string& browseName) {
+    if(ids.empty()) {
+      return;
+    }
+    UA_DeleteMonitoredItemsRequest request;
+    UA_DeleteMonitoredItemsRequest_init(&request);
+    request.subscriptionId = _subscriptionID;
+    // the ids are only borrowed - the request is not cleared
+    request.monitoredItemIds = const_cast<UA_UInt32*>(ids.data());
+    request.monitoredItemIdsSize = ids.size();
+    UA_DeleteMonitoredItemsResponse response;
+    {
+      std::lock_guard<std::mutex> connection_lock(_connection->client_lock);
+      // UA_Client_MonitoredItems_delete tries to update the latest value which triggers responseHandler
+      response = UA_Client_MonitoredItems_delete(_connection->client.get(), request);
+    }
+    UA_StatusCode ret = response.responseHeader.serviceResult;
+    for(size_t i = 0; ret == UA_STATUSCODE_GOOD && i < response.resultsSize; ++i) {
+      ret = response.results[i];
+    }
+    UA_DeleteMonitoredItemsResponse_clear(&response);
+
+    if(!ret) {
+      UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "%zu monitored item(s) removed for: %s",
+          ids.size(), browseName.c_str());
+    }
+    else {
+      UA_LOG_ERROR(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Failed to unsubscribe item (no client alive): %s Error: %s", browseName.c_str(), UA_StatusCode_name(ret));
+    }
+  }
+
+  std::vector<UA_UInt32> OPCUASubscriptionManager::releaseMonitoredItems(MonitorItem& item) {
+    auto ids = item.getMonitoredIds();
+    for(auto id : ids) {
+      subscriptionMap.erase(id);
+    }
+    item.chunks.clear();
+    item.isMonitored = false;
+    return ids;
+  }
+
+  void OPCUASubscriptionManager::pushPendingItems() {
+    if(!_itemsPending.exchange(false) && !_clientAggregates) {
+      return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto& item : _items) {
+      if(item.isAggregate()) {
+        if(item.active && !item.aggregate.onServer && item.aggregateReady(now)) {
+          item.finishAggregate();
+          for(auto& accessor : item.accessors) {
+            item.push(accessor);
+          }
+        }
+        continue;
+      }
+      if(!item.pending || !item.active || !item.isComplete()) {
+        // incomplete items are pushed as soon as the initial values of all chunks are received
+        continue;
+      }
+      item.pending = false;
+      UA_LOG_DEBUG(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND,
+          "Pushing pending data to queue for %zu accessors.", item.accessors.size());
+      for(auto& accessor : item.accessors) {
+        // other accessors of items that are not chunked already got each sample in the responseHandler
+        if((item.chunks.size() > 1 || accessor->isHistory()) &&
+            !item.hasValue(accessor, item.lastValue.getSourceTime())) {
+          item.push(accessor);
+        }
+      }
+      item.replacedAccessors.clear();
+    }
+  }
+
+  void OPCUASubscriptionManager::releasePooledItems() {
+    if(!_hasPooledItems) {
+      return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    auto gracePeriod = std::chrono::milliseconds(_connection->subscriptionSettings.itemGracePeriod);
+    std::vector<UA_UInt32> ids;
+    size_t nReleased = 0;
+    bool isEmpty = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::vector<std::list<MonitorItem>::iterator> pooled;
+      for(auto it = _items.begin(); it != _items.end(); ++it) {
+        if(it->isPooled()) {
+          pooled.push_back(it);
+        }
+      }
+      // oldest first
+      std::sort(pooled.begin(), pooled.end(),
+          [](const auto& a, const auto& b) { return a->pooledSince < b->pooledSince; });
+      size_t maxPooled = _connection->subscriptionSettings.maxPooledItems;
+      size_t excess = pooled.size() > maxPooled ? pooled.size() - maxPooled : 0;
+      for(size_t i = 0; i < pooled.size(); ++i) {
+        if(i >= excess && now - pooled[i]->pooledSince < gracePeriod) {
+          break;
+        }
+        auto itemIds = releaseMonitoredItems(*pooled[i]);
+        ids.insert(ids.end(), itemIds.begin(), itemIds.end());
+        _items.erase(pooled[i]);
+        ++nReleased;
+      }
+      _hasPooledItems = nReleased < pooled.size();
+      isEmpty = nReleased > 0 && _items.empty();
+    }
+    if(nReleased > 0) {
+      removeMonitoredItems(ids, std::to_string(nReleased) + " pooled items");
+    }
+    if(isEmpty) {
+      // as in unsubscribe() the subscription is removed with the last item - this is called by the client thread, so
+      // the subscription is removed by runClient() once the client loop is left
+      _subscriptionNeedsToBeRemoved = true;
+      _run = false;
+    }
+  }
+
   void OPCUASubscriptionManager::handleException(const std::string& message) {
     std::lock_guard<std::mutex> lock(mutex);
     UA_LOG_INFO(&OpcUABackend::backendLogger, UA_LOGCATEGORY_USERLAND, "Handling error: %s", message.c_str());
@@ -428,11 +1568,13 @@ namespace ChimeraTK {
     }
   }
 
-  void OPCUASubscriptionManager::setExternalError(const std::string& browseName) {
-    auto it = std::find(_items.begin(), _items.end(), browseName);
-    if(it != _items.end()) {
-      std::lock_guard<std::mutex> lock(mutex);
-      it->hasException = true;
+  void OPCUASubscriptionManager::setExternalError(const UA_NodeId& node) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // several items might monitor the node
+    for(auto& item : _items) {
+      if(item == node) {
+        item.hasException = true;
+      }
     }
   }
 
@@ -21,9 +21,20 @@ timePoint_t VersionMapper::convertToTimePoint(const UA_DateTime& timeStamp) {
 
 ChimeraTK::VersionNumber VersionMapper::getVersion(const UA_DateTime& timeStamp) {
   std::lock_guard<std::mutex> lock(_mapMutex);
-  if(!_versionMap.count(timeStamp)) {
-    if(_versionMap.size() == maxSizeEventIdMap) _versionMap.erase(_versionMap.begin());
-    _versionMap[timeStamp] = ChimeraTK::VersionNumber(convertToTimePoint(timeStamp));
+  auto it = _versionMap.find(timeStamp);
+  if(it != _versionMap.end()) {
+    return it->second;
   }
-  return _versionMap[timeStamp];
+  ChimeraTK::VersionNumber version(convertToTimePoint(timeStamp));
+  if(_versionMap.size() == maxSizeEventIdMap) {
+    // reuse the node of the oldest entry, so no memory is allocated once the map is full
+    auto node = _versionMap.extract(_versionMap.begin());
+    node.key() = timeStamp;
+    node.mapped() = version;
+    _versionMap.insert(std::move(node));
+  }
+  else {
+    _versionMap.emplace(timeStamp, version);
+  }
+  return version;
 }
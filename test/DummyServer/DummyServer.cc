@@ -12,10 +12,20 @@
 #include <open62541/client_config_default.h>
 #include <open62541/plugin/log_stdout.h>
 #include <open62541/server_config_default.h>
+#ifdef UA_ENABLE_PUBSUB
+#  include <open62541/server_pubsub.h>
+#endif
+#ifdef UA_ENABLE_HISTORIZING
+#  include <open62541/plugin/historydata/history_data_backend_memory.h>
+#  include <open62541/plugin/historydata/history_data_gathering_default.h>
+#  include <open62541/plugin/historydata/history_database_default.h>
+#endif
 
 #include <boost/fusion/include/at_key.hpp>
 #include <boost/fusion/include/for_each.hpp>
 
+#include <cstddef>
+#include <cstring>
 #include <memory>
 #include <random>
 #include <stdexcept>
@@ -25,6 +35,32 @@ namespace fusion = boost::fusion;
 
 UA_Logger OPCUAServer::logger;
 
+// clang-format off
+static UA_DataTypeMember statusMembers[4] = {
+    {UA_TYPENAME("counter") &UA_TYPES[UA_TYPES_INT32], 0, false, false},
+    {UA_TYPENAME("temperature") &UA_TYPES[UA_TYPES_DOUBLE],
+        offsetof(DummyStatus, temperature) - offsetof(DummyStatus, counter) - sizeof(UA_Int32), false, false},
+    {UA_TYPENAME("ok") &UA_TYPES[UA_TYPES_BOOLEAN],
+        offsetof(DummyStatus, ok) - offsetof(DummyStatus, temperature) - sizeof(UA_Double), false, false},
+    {UA_TYPENAME("name") &UA_TYPES[UA_TYPES_STRING],
+        offsetof(DummyStatus, name) - offsetof(DummyStatus, ok) - sizeof(UA_Boolean), false, false}};
+
+static UA_DataType statusType = {
+    UA_TYPENAME("DummyStatus")          /* .typeName */
+    {1, UA_NODEIDTYPE_NUMERIC, {4242}}, /* .typeId */
+    {1, UA_NODEIDTYPE_NUMERIC, {4243}}, /* .binaryEncodingId */
+    {0, UA_NODEIDTYPE_NUMERIC, {0}},    /* .xmlEncodingId */
+    sizeof(DummyStatus),                /* .memSize */
+    UA_DATATYPEKIND_STRUCTURE,          /* .typeKind */
+    false,                              /* .pointerFree */
+    false,                              /* .overlayable */
+    4,                                  /* .membersSize */
+    statusMembers};
+// clang-format on
+
+// the server encodes DummyStatus values, the client only knows the definition read from the server
+static UA_DataTypeArray statusTypes = {nullptr, 1, &statusType, false};
+
 TypeMapWithName dummyMap(fusion::make_pair<UA_Int16>(std::make_pair("int16", UA_TYPES_INT16)),
     fusion::make_pair<UA_UInt16>(std::make_pair("uint16", UA_TYPES_UINT16)),
     fusion::make_pair<UA_Int32>(std::make_pair("int32", UA_TYPES_INT32)),
@@ -246,9 +282,19 @@ void OPCUAServer::start() {
   UA_ServerConfig_setMinimal(&config, port, NULL);
   config.publishingIntervalLimits = getDuration(publishingInterval, 3600.0 * 1000.0);
   config.samplingIntervalLimits = getDuration(publishingInterval, 24.0 * 3600.0 * 1000.0);
+  config.customDataTypes = &statusTypes;
+#ifdef UA_ENABLE_HISTORIZING
+  historyGathering = UA_HistoryDataGathering_Default(1);
+  config.historyDatabase = UA_HistoryDatabase_default(historyGathering);
+#endif
   server = UA_Server_newWithConfig(&config);
 
   addVariables();
+#ifdef UA_ENABLE_PUBSUB
+  if(!pubSubUrl.empty()) {
+    addPublisher();
+  }
+#endif
   configured = true;
   running = true;
   // run the server
@@ -314,10 +360,246 @@ void OPCUAServer::addVariables() {
   boost::fusion::for_each(dummyMap, VariableAttacher(UA_NODEID("ns=1;s=Dummy/scalar_ro"), server, false, true));
   addFolder("Dummy/array_ro", id);
   boost::fusion::for_each(dummyMap, VariableAttacher(UA_NODEID("ns=1;s=Dummy/array_ro"), server, true, true));
+  addFolder("Dummy/blob", id);
+  addByteStrings(UA_NODEID("ns=1;s=Dummy/blob"));
+  addFolder("Dummy/large", id);
+  addLargeArray(UA_NODEID("ns=1;s=Dummy/large"));
+  addFolder("Dummy/matrix", id);
+  addMatrix(UA_NODEID("ns=1;s=Dummy/matrix"));
+  addFolder("Dummy/channels", id);
+  addChannelNodes(UA_NODEID("ns=1;s=Dummy/channels"));
+  addFolder("Dummy/single", id);
+  addSingleElementArray(UA_NODEID("ns=1;s=Dummy/single"));
+  addFolder("Dummy/struct", id);
+  addStructure(UA_NODEID("ns=1;s=Dummy/struct"));
   UA_NodeId_clear(&id);
   UA_ObjectAttributes_clear(&oAttr);
 }
 
+void OPCUAServer::addByteStrings(UA_NodeId parent) {
+  // scalar with 8 bytes 0..7 and array of two blobs with 4 bytes each 0..3 and 4..7
+  UA_Byte bytes[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  UA_ByteString scalar{8, bytes};
+  UA_ByteString array[2] = {{4, bytes}, {4, bytes + 4}};
+  for(std::string name : {"scalar", "array"}) {
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    if(name == "scalar") {
+      UA_Variant_setScalar(&attr.value, &scalar, &UA_TYPES[UA_TYPES_BYTESTRING]);
+      attr.valueRank = -1;
+    }
+    else {
+      UA_Variant_setArray(&attr.value, array, 2, &UA_TYPES[UA_TYPES_BYTESTRING]);
+      attr.valueRank = 1;
+    }
+    attr.dataType = UA_TYPES[UA_TYPES_BYTESTRING].typeId;
+    attr.displayName = UA_LOCALIZEDTEXT((char*)"en_US", &name[0]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    attr.userAccessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    std::string nodeName = "Dummy/blob/" + name;
+    UA_Server_addVariableNode(server, UA_NODEID_STRING(1, &nodeName[0]), parent, UA_NS0ID(ORGANIZES),
+        UA_QUALIFIEDNAME(1, &name[0]), UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+  }
+}
+
+void OPCUAServer::addLargeArray(UA_NodeId parent) {
+  std::vector<UA_Double> values(largeArraySize);
+  for(size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<UA_Double>(i);
+  }
+  UA_VariableAttributes attr = UA_VariableAttributes_default;
+  UA_Variant_setArray(&attr.value, values.data(), values.size(), &UA_TYPES[UA_TYPES_DOUBLE]);
+  attr.valueRank = 1;
+  UA_UInt32 arrayDimensions[1] = {static_cast<UA_UInt32>(values.size())};
+  attr.arrayDimensions = arrayDimensions;
+  attr.arrayDimensionsSize = 1;
+  attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+  attr.displayName = UA_LOCALIZEDTEXT((char*)"en_US", (char*)"double");
+  attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+  attr.userAccessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+  UA_Server_addVariableNode(server, UA_NODEID_STRING(1, (char*)"Dummy/large/double"), parent, UA_NS0ID(ORGANIZES),
+      UA_QUALIFIEDNAME(1, (char*)"double"), UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+}
+
+void OPCUAServer::addMatrix(UA_NodeId parent) {
+  std::vector<UA_Int32> values(matrixRows * matrixColumns);
+  for(size_t row = 0; row < matrixRows; ++row) {
+    for(size_t column = 0; column < matrixColumns; ++column) {
+      values[row * matrixColumns + column] = static_cast<UA_Int32>(10 * row + column);
+    }
+  }
+  UA_UInt32 arrayDimensions[2] = {static_cast<UA_UInt32>(matrixRows), static_cast<UA_UInt32>(matrixColumns)};
+  UA_VariableAttributes attr = UA_VariableAttributes_default;
+  UA_Variant_setArray(&attr.value, values.data(), values.size(), &UA_TYPES[UA_TYPES_INT32]);
+  attr.value.arrayDimensions = arrayDimensions;
+  attr.value.arrayDimensionsSize = 2;
+  attr.valueRank = 2;
+  attr.arrayDimensions = arrayDimensions;
+  attr.arrayDimensionsSize = 2;
+  attr.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+  attr.displayName = UA_LOCALIZEDTEXT((char*)"en_US", (char*)"int32");
+  attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+  attr.userAccessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+  UA_Server_addVariableNode(server, UA_NODEID_STRING(1, (char*)"Dummy/matrix/int32"), parent, UA_NS0ID(ORGANIZES),
+      UA_QUALIFIEDNAME(1, (char*)"int32"), UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+}
+
+void OPCUAServer::addChannelNodes(UA_NodeId parent) {
+  for(size_t i = 0; i < numberOfChannelNodes; ++i) {
+    UA_Double value = 10. * static_cast<UA_Double>(i) + 0.5;
+    std::string name = "amplitude" + std::to_string(i);
+    std::string nodeName = "Dummy/channels/" + name;
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    UA_Variant_setScalar(&attr.value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    attr.valueRank = -1;
+    attr.dataType = UA_TYPES[UA_TYPES_DOUBLE].typeId;
+    attr.displayName = UA_LOCALIZEDTEXT((char*)"en_US", &name[0]);
+    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    attr.userAccessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+    UA_Server_addVariableNode(server, UA_NODEID_STRING(1, &nodeName[0]), parent, UA_NS0ID(ORGANIZES),
+        UA_QUALIFIEDNAME(1, &name[0]), UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+  }
+}
+
+void OPCUAServer::addSingleElementArray(UA_NodeId parent) {
+  UA_Int32 value = 42;
+  UA_VariableAttributes attr = UA_VariableAttributes_default;
+  UA_Variant_setArray(&attr.value, &value, 1, &UA_TYPES[UA_TYPES_INT32]);
+  attr.valueRank = UA_VALUERANK_ANY;
+  attr.dataType = UA_TYPES[UA_TYPES_INT32].typeId;
+  attr.displayName = UA_LOCALIZEDTEXT((char*)"en_US", (char*)"int32");
+  attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+  attr.userAccessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+  UA_Server_addVariableNode(server, UA_NODEID_STRING(1, (char*)"Dummy/single/int32"), parent, UA_NS0ID(ORGANIZES),
+      UA_QUALIFIEDNAME(1, (char*)"int32"), UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+}
+
+static void countRead(UA_Server* /*server*/, const UA_NodeId* /*sessionId*/, void* /*sessionContext*/,
+    const UA_NodeId* /*nodeId*/, void* nodeContext, const UA_NumericRange* /*range*/, const UA_DataValue* /*value*/) {
+  auto* dummy = static_cast<OPCUAServer*>(nodeContext);
+  ++dummy->reads;
+  if(dummy->onRead) {
+    dummy->onRead();
+  }
+}
+
+void OPCUAServer::watchReads(std::string nodeName) {
+  UA_NodeId id = UA_NODEID_STRING(1, &nodeName[0]);
+  UA_ValueCallback callback;
+  callback.onRead = countRead;
+  callback.onWrite = nullptr;
+  lock();
+  UA_Server_setNodeContext(server, id, this);
+  UA_Server_setVariableNode_valueCallback(server, id, callback);
+  unlock();
+}
+
+#ifdef UA_ENABLE_HISTORIZING
+void OPCUAServer::historize(std::string nodeName) {
+  UA_NodeId id = UA_NODEID_STRING(1, &nodeName[0]);
+  UA_HistorizingNodeIdSettings settings;
+  memset(&settings, 0, sizeof(settings));
+  settings.historizingBackend = UA_HistoryDataBackend_Memory(1, 100);
+  settings.maxHistoryDataResponseSize = 100;
+  settings.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_VALUESET;
+  lock();
+  UA_Byte accessLevel = 0;
+  UA_Server_readAccessLevel(server, id, &accessLevel);
+  UA_Server_writeAccessLevel(server, id, accessLevel | UA_ACCESSLEVELMASK_HISTORYREAD);
+  UA_Server_writeHistorizing(server, id, true);
+  historyGathering.registerNodeId(server, historyGathering.context, &id, settings);
+  unlock();
+}
+#endif
+
+void OPCUAServer::addStructure(UA_NodeId parent) {
+  UA_DataTypeAttributes typeAttr = UA_DataTypeAttributes_default;
+  typeAttr.displayName = UA_LOCALIZEDTEXT((char*)"en_US", (char*)"DummyStatus");
+  UA_Server_addDataTypeNode(server, statusType.typeId, UA_NS0ID(STRUCTURE), UA_NS0ID(HASSUBTYPE),
+      UA_QUALIFIEDNAME(1, (char*)"DummyStatus"), typeAttr, NULL, NULL);
+
+  DummyStatus status{42, 21.5, true, UA_STRING((char*)"dummy")};
+  UA_VariableAttributes attr = UA_VariableAttributes_default;
+  UA_Variant_setScalar(&attr.value, &status, &statusType);
+  attr.valueRank = -1;
+  attr.dataType = statusType.typeId;
+  attr.displayName = UA_LOCALIZEDTEXT((char*)"en_US", (char*)"status");
+  attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+  attr.userAccessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;
+  UA_Server_addVariableNode(server, UA_NODEID_STRING(1, (char*)"Dummy/struct/status"), parent, UA_NS0ID(ORGANIZES),
+      UA_QUALIFIEDNAME(1, (char*)"status"), UA_NS0ID(BASEDATAVARIABLETYPE), attr, NULL, NULL);
+}
+
+void OPCUAServer::setStatus(const DummyStatus& status) {
+  UA_Variant data;
+  UA_Variant_setScalar(&data, const_cast<DummyStatus*>(&status), &statusType);
+  lock();
+  UA_Server_writeValue(server, UA_NODEID_STRING(1, (char*)"Dummy/struct/status"), data);
+  unlock();
+  std::this_thread::sleep_for(std::chrono::milliseconds(2 * publishingInterval));
+}
+
+#ifdef UA_ENABLE_PUBSUB
+void OPCUAServer::addPublisher() {
+  UA_PubSubConnectionConfig connectionConfig;
+  memset(&connectionConfig, 0, sizeof(UA_PubSubConnectionConfig));
+  connectionConfig.name = UA_STRING((char*)"UADP Connection");
+  connectionConfig.transportProfileUri =
+      UA_STRING((char*)"http://opcfoundation.org/UA-Profile/Transport/pubsub-udp-uadp");
+  UA_NetworkAddressUrlDataType networkAddressUrl = {UA_STRING_NULL, UA_STRING(&pubSubUrl[0])};
+  UA_Variant_setScalar(&connectionConfig.address, &networkAddressUrl, &UA_TYPES[UA_TYPES_NETWORKADDRESSURLDATATYPE]);
+  connectionConfig.publisherId.idType = UA_PUBLISHERIDTYPE_UINT16;
+  connectionConfig.publisherId.id.uint16 = 2234;
+  UA_NodeId connectionId;
+  UA_Server_addPubSubConnection(server, &connectionConfig, &connectionId);
+
+  UA_PublishedDataSetConfig publishedDataSetConfig;
+  memset(&publishedDataSetConfig, 0, sizeof(UA_PublishedDataSetConfig));
+  publishedDataSetConfig.publishedDataSetType = UA_PUBSUB_DATASET_PUBLISHEDITEMS;
+  publishedDataSetConfig.name = UA_STRING((char*)"Dummy PDS");
+  UA_NodeId publishedDataSetId;
+  UA_Server_addPublishedDataSet(server, &publishedDataSetConfig, &publishedDataSetId);
+
+  for(std::string name : {"Dummy/scalar/int32", "Dummy/scalar/double"}) {
+    UA_DataSetFieldConfig dataSetFieldConfig;
+    memset(&dataSetFieldConfig, 0, sizeof(UA_DataSetFieldConfig));
+    dataSetFieldConfig.dataSetFieldType = UA_PUBSUB_DATASETFIELD_VARIABLE;
+    dataSetFieldConfig.field.variable.fieldNameAlias = UA_STRING(&name[0]);
+    dataSetFieldConfig.field.variable.promotedField = false;
+    dataSetFieldConfig.field.variable.publishParameters.publishedVariable = UA_NODEID_STRING(1, &name[0]);
+    dataSetFieldConfig.field.variable.publishParameters.attributeId = UA_ATTRIBUTEID_VALUE;
+    UA_NodeId dataSetFieldId;
+    UA_Server_addDataSetField(server, publishedDataSetId, &dataSetFieldConfig, &dataSetFieldId);
+  }
+
+  UA_WriterGroupConfig writerGroupConfig;
+  memset(&writerGroupConfig, 0, sizeof(UA_WriterGroupConfig));
+  writerGroupConfig.name = UA_STRING((char*)"Dummy WriterGroup");
+  writerGroupConfig.publishingInterval = publishingInterval;
+  writerGroupConfig.writerGroupId = 100;
+  writerGroupConfig.encodingMimeType = UA_PUBSUB_ENCODING_UADP;
+  UA_UadpWriterGroupMessageDataType* writerGroupMessage = UA_UadpWriterGroupMessageDataType_new();
+  writerGroupMessage->networkMessageContentMask =
+      (UA_UadpNetworkMessageContentMask)(UA_UADPNETWORKMESSAGECONTENTMASK_PUBLISHERID |
+          (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_GROUPHEADER |
+          (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_WRITERGROUPID |
+          (UA_UadpNetworkMessageContentMask)UA_UADPNETWORKMESSAGECONTENTMASK_PAYLOADHEADER);
+  UA_ExtensionObject_setValue(
+      &writerGroupConfig.messageSettings, writerGroupMessage, &UA_TYPES[UA_TYPES_UADPWRITERGROUPMESSAGEDATATYPE]);
+  UA_NodeId writerGroupId;
+  UA_Server_addWriterGroup(server, connectionId, &writerGroupConfig, &writerGroupId);
+  UA_UadpWriterGroupMessageDataType_delete(writerGroupMessage);
+
+  UA_DataSetWriterConfig dataSetWriterConfig;
+  memset(&dataSetWriterConfig, 0, sizeof(UA_DataSetWriterConfig));
+  dataSetWriterConfig.name = UA_STRING((char*)"Dummy DataSetWriter");
+  dataSetWriterConfig.dataSetWriterId = 62541;
+  dataSetWriterConfig.keyFrameCount = 10;
+  UA_NodeId dataSetWriterId;
+  UA_Server_addDataSetWriter(server, writerGroupId, publishedDataSetId, &dataSetWriterConfig, &dataSetWriterId);
+  UA_Server_enableAllPubSubComponents(server);
+}
+#endif
+
 UA_Variant* OPCUAServer::getValue(std::string nodeName) {
   UA_Variant* data = UA_Variant_new();
   UA_Server_readValue(server, UA_NODEID_STRING(1, &nodeName[0]), data);
@@ -14,11 +14,15 @@
 #include <open62541/plugin/log_stdout.h>
 #include <open62541/server.h>
 #include <open62541/types.h>
+#ifdef UA_ENABLE_HISTORIZING
+#  include <open62541/plugin/historydata/history_data_gathering.h>
+#endif
 
 #include <boost/fusion/container/map.hpp>
 
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -42,6 +46,17 @@ extern TypeMapWithName dummyMap;
 
 enum ServerState { On, Off };
 
+/**
+ * Content of the structure node Dummy/struct/status. It is a custom data type of the server (ns=1;i=4242) that is not
+ * known to the client.
+ */
+struct DummyStatus {
+  UA_Int32 counter;
+  UA_Double temperature;
+  UA_Boolean ok;
+  UA_String name;
+};
+
 // The publishing and sampling interval used in the tests
 static constexpr int publishingInterval{20}; // ms
 static constexpr UA_LogLevel testServerLogLevel{UA_LOGLEVEL_ERROR};
@@ -81,6 +96,86 @@ struct OPCUAServer {
 
   void addVariables();
 
+  /**
+   * Add the ByteString nodes Dummy/blob/scalar (8 bytes) and Dummy/blob/array (2 blobs with 4 bytes each).
+   */
+  void addByteStrings(UA_NodeId parent);
+
+  /// Number of elements of Dummy/large/double
+  static constexpr size_t largeArraySize{100000};
+
+  /**
+   * Add the double array Dummy/large/double with largeArraySize elements, which are set to their index.
+   */
+  void addLargeArray(UA_NodeId parent);
+
+  /// Number of rows and columns of Dummy/matrix/int32
+  static constexpr size_t matrixRows{3};
+  static constexpr size_t matrixColumns{4};
+
+  /**
+   * Add the two-dimensional int32 array Dummy/matrix/int32. Element (row, column) is set to 10 * row + column.
+   */
+  void addMatrix(UA_NodeId parent);
+
+  /// Number of nodes in Dummy/channels
+  static constexpr size_t numberOfChannelNodes{4};
+
+  /**
+   * Add the double nodes Dummy/channels/amplitude0 ... amplitude3, which are set to 10 * index + 0.5.
+   */
+  void addChannelNodes(UA_NodeId parent);
+
+  /**
+   * Add the int32 node Dummy/single/int32 with value rank any (-2) holding an array of one element set to 42. So the
+   * server accepts scalars and arrays written to it.
+   */
+  void addSingleElementArray(UA_NodeId parent);
+
+  /**
+   * Count the reads of the given node in reads and call onRead for each read if it is set. Reads done by the server
+   * itself, e.g. in getValue() or when sampling monitored items, are counted as well.
+   */
+  void watchReads(std::string nodeName);
+
+  /// Number of reads of the nodes passed to watchReads()
+  std::atomic<size_t> reads{0};
+
+  /// Called by the server thread for each read of the nodes passed to watchReads(), i.e. blocking it blocks the server
+  std::function<void()> onRead;
+
+  /**
+   * Add the data type node of DummyStatus and the structure node Dummy/struct/status (counter 42, temperature 21.5,
+   * ok true, name "dummy").
+   */
+  void addStructure(UA_NodeId parent);
+
+  /**
+   * Write the structure node Dummy/struct/status.
+   */
+  void setStatus(const DummyStatus& status);
+
+  /**
+   * Address used to publish Dummy/scalar/int32 and Dummy/scalar/double via PubSub (publisherId 2234, writerGroupId 100,
+   * dataSetWriterId 62541). If empty nothing is published. Has to be set before starting the server.
+   */
+  std::string pubSubUrl;
+
+#ifdef UA_ENABLE_PUBSUB
+  void addPublisher();
+#endif
+
+#ifdef UA_ENABLE_HISTORIZING
+  /**
+   * Store all values written to the given node in the history of the server, so they can be read by HistoryRead. The
+   * history is kept in memory and is lost when the server is restarted.
+   */
+  void historize(std::string nodeName);
+
+  /// Collects the history of the nodes passed to historize(). It is owned by the history database of the server.
+  UA_HistoryDataGathering historyGathering;
+#endif
+
   template<typename UAType>
   void setValue(std::string nodeName, const std::vector<UAType>& t, const size_t& length = 1);
 
@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: Helmholtz-Zentrum Dresden-Rossendorf, FWKE, ChimeraTK Project <chimeratk-support@desy.de>
+// SPDX-License-Identifier: LGPL-3.0-or-later
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * TCP proxy that forwards all data between a client and the server on localhost after a fixed delay. The data sent by
+ * the client is recorded, so tests can check what was requested from the server.
+ */
+class TcpProxy {
+ public:
+  explicit TcpProxy(uint targetPort, std::chrono::milliseconds delay = std::chrono::milliseconds(0))
+  : _targetPort(targetPort), _delay(delay) {
+    _listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if(bind(_listenSocket, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(_listenSocket, 4) != 0) {
+      throw std::runtime_error("Failed to set up the TCP proxy.");
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(_listenSocket, (sockaddr*)&addr, &len);
+    port = ntohs(addr.sin_port);
+    _acceptThread = std::thread(&TcpProxy::acceptLoop, this);
+  }
+
+  ~TcpProxy() {
+    _running = false;
+    shutdown(_listenSocket, SHUT_RDWR);
+    close(_listenSocket);
+    _acceptThread.join();
+    for(auto& c : _connections) {
+      shutdown(c.first, SHUT_RDWR);
+      shutdown(c.second, SHUT_RDWR);
+    }
+    for(auto& t : _pumps) {
+      t.join();
+    }
+    for(auto& c : _connections) {
+      close(c.first);
+      close(c.second);
+    }
+  }
+
+  uint port{0};
+
+  /// Record the data sent by the client (off by default)
+  std::atomic<bool> record{false};
+
+  /**
+   * Check if the data sent by the client since the last call of clearRecorded() contains the given bytes.
+   */
+  bool recorded(const void* bytes, size_t size) {
+    std::lock_guard<std::mutex> lock(_recordMutex);
+    auto* begin = static_cast<const char*>(bytes);
+    return std::search(_recorded.begin(), _recorded.end(), begin, begin + size) != _recorded.end();
+  }
+
+  void clearRecorded() {
+    std::lock_guard<std::mutex> lock(_recordMutex);
+    _recorded.clear();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Chunk {
+    Clock::time_point due;
+    std::vector<char> data;
+  };
+
+  void acceptLoop() {
+    while(_running) {
+      int client = accept(_listenSocket, nullptr, nullptr);
+      if(client < 0) {
+        continue;
+      }
+      int server = socket(AF_INET, SOCK_STREAM, 0);
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      addr.sin_port = htons(_targetPort);
+      if(connect(server, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(client);
+        close(server);
+        continue;
+      }
+      _connections.emplace_back(client, server);
+      _pumps.emplace_back(&TcpProxy::pump, this, client, server, true);
+      _pumps.emplace_back(&TcpProxy::pump, this, server, client, false);
+    }
+  }
+
+  void pump(int from, int to, bool fromClient) {
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<Chunk> queue;
+    bool done = false;
+    std::thread sender([&] {
+      std::unique_lock<std::mutex> lock(m);
+      while(true) {
+        cv.wait(lock, [&] { return done || !queue.empty(); });
+        if(queue.empty()) {
+          return;
+        }
+        auto chunk = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        std::this_thread::sleep_until(chunk.due);
+        send(to, chunk.data.data(), chunk.data.size(), MSG_NOSIGNAL);
+        lock.lock();
+      }
+    });
+    std::vector<char> buffer(65536);
+    while(true) {
+      auto n = recv(from, buffer.data(), buffer.size(), 0);
+      if(n <= 0) {
+        break;
+      }
+      if(fromClient && record) {
+        std::lock_guard<std::mutex> lock(_recordMutex);
+        _recorded.insert(_recorded.end(), buffer.begin(), buffer.begin() + n);
+      }
+      std::lock_guard<std::mutex> lock(m);
+      queue.push_back({Clock::now() + _delay, std::vector<char>(buffer.begin(), buffer.begin() + n)});
+      cv.notify_one();
+    }
+    {
+      std::lock_guard<std::mutex> lock(m);
+      done = true;
+      cv.notify_one();
+    }
+    sender.join();
+    shutdown(to, SHUT_WR);
+  }
+
+  uint _targetPort;
+  std::chrono::milliseconds _delay;
+  int _listenSocket;
+  std::atomic<bool> _running{true};
+  std::thread _acceptThread;
+  std::vector<std::pair<int, int>> _connections;
+  std::vector<std::thread> _pumps;
+  std::mutex _recordMutex;
+  std::vector<char> _recorded;
+};